@@ -2,6 +2,8 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <array>
+#include <charconv>
 #include <fmt/format.h>
 #include "endian.h"
 #include "exceptions.h"
@@ -73,7 +75,12 @@ namespace dlt {
   template <bool BigEndian>
   class ArgParser {
   public:
-    ArgParser(const uint8_t* payload, uint8_t count) : payload_(payload) {
+    // arguments are read from [payload, end) only and appended to output
+    // the output buffer is meant to be reused, so formatting does not allocate once it has grown enough
+    ArgParser(const uint8_t* payload, const uint8_t* end, uint8_t count, std::string& output)
+      : payload_(payload), end_(end), output_(output) {
+      // numbers take about twice their size in text
+      output_.reserve(std::size(output_) + static_cast<std::size_t>(end - payload) * 2);
       while (count > 1) {
         parse();
         // this is odd but conform to DLT viewer
@@ -87,51 +94,90 @@ namespace dlt {
       }
     }
 
-    operator std::string() && {
-      return std::move(output_);
+    // arguments without type info in the payload (non-verbose): they are appended one by one by parse(type)
+    ArgParser(const uint8_t* payload, const uint8_t* end, std::string& output)
+      : payload_(payload), end_(end), output_(output) {
+      output_.reserve(std::size(output_) + static_cast<std::size_t>(end - payload) * 2);
     }
 
     void parse() {
-      using namespace detail;
-      using conformance::ArgType;
-      using conformance::ArgTyleMask;
-      using conformance::ArgCodingMask;
+      require(sizeof(conformance::ArgType));
+      const auto type = endian::read<uint32_t>(payload_, BigEndian);
+      payload_ += sizeof(conformance::ArgType);
+      parse(type);
+    }
 
-      const auto type = static_cast<ArgType>(endian::read<uint32_t>(payload_, BigEndian));
-      payload_ += sizeof(ArgType);
+    // the argument of this type info is next in the payload
+    void parse(const uint32_t type) {
+      // two lookups instead of testing the type flags one by one and switching on tyle/coding then
+      DECODERS[decoderIndex(KINDS[(type >> KIND_SHIFT) & KIND_MASK], type)](*this);
+    }
 
-      if (type & ArgType::INFO_STRG) {
-        if (type & ArgType::INFO_VARI) {
-          throw except::parse_exception("how could string be variable?");
+    // the end of count arguments in [payload, end) as the constructor reads them, nullptr wherever it throws
+    // nothing is formatted: only type info and lengths are looked at
+    static const uint8_t* skip(const uint8_t* payload, const uint8_t* end, uint8_t count) noexcept {
+      for (; count > 0 && payload != nullptr; --count) {
+        if (static_cast<std::size_t>(end - payload) < sizeof(conformance::ArgType)) {
+          return nullptr;
         }
-        return parseStr(type & ArgCodingMask);
-      }
-      if (type & ArgType::INFO_UINT) {
-        return parseUInt(type & ArgTyleMask, type & ArgCodingMask);
-      }
-      if (type & ArgType::INFO_SINT) {
-        return parseSInt(type & ArgTyleMask);
+        const auto type = endian::read<uint32_t>(payload, BigEndian);
+        payload = skip(type, payload + sizeof(conformance::ArgType), end);
       }
-      if (type & ArgType::INFO_FLOA) {
-        return parseFloat(type & ArgTyleMask);
-      }
-      if (type & ArgType::INFO_BOOL) {
-        return parseBool();
-      }
-      if (type & ArgType::INFO_RAWD) {
-        return parseRaw();
+      return payload;
+    }
+
+    // the same for the argument of this type info as parse(type) reads it
+    static const uint8_t* skip(const uint32_t type, const uint8_t* payload, const uint8_t* end) noexcept {
+      using conformance::TyleType;
+      const auto left = static_cast<std::size_t>(end - payload);
+      const auto fixed = [payload, left](const std::size_t size) -> const uint8_t* {
+        return left < size ? nullptr : payload + size;
+      };
+      const auto tyle = static_cast<TyleType>(type & 0xf);
+
+      switch (const auto kind = KINDS[(type >> KIND_SHIFT) & KIND_MASK]) {
+      case Kind::String:
+      case Kind::Raw:
+      {
+        if (left < sizeof(uint16_t)) {
+          return nullptr;
+        }
+        const auto len = endian::read<uint16_t>(payload, BigEndian);
+        const auto data = payload + sizeof(len);
+        if (left - sizeof(len) < len) {
+          return nullptr;
+        }
+        // see parseStr: only null-terminated ascii is accepted
+        if (kind == Kind::String && (len == 0 || ((type >> CODING_SHIFT) & 0x7) != 0 || data[len - 1] != '\0')) {
+          return nullptr;
+        }
+        return data + len;
       }
-      if (type & ArgType::INFO_FIXP || type & ArgType::INFO_TRAI || type & ArgType::INFO_STRU) {
-        throw except::parse_exception("not supported yet");
+      case Kind::UInt:
+      case Kind::SInt:
+        return tyle >= TyleType::TYLE_8BIT && tyle <= TyleType::TYLE_64BIT
+          ? fixed(std::size_t{ 1 } << (static_cast<unsigned>(tyle) - 1)) : nullptr;
+      case Kind::Float:
+        return tyle == TyleType::TYLE_32BIT ? fixed(sizeof(float)) : tyle == TyleType::TYLE_64BIT ? fixed(sizeof(double)) : nullptr;
+      case Kind::Bool:
+        return fixed(sizeof(bool));
+      default:
+        return nullptr;
       }
-      throw except::parse_exception("unknown argument type");
     }
 
   private:
+    void require(const std::size_t bytes) const {
+      if (static_cast<std::size_t>(end_ - payload_) < bytes) {
+        throw except::parse_exception("argument exceeds payload");
+      }
+    }
+
     /* parse string */
     void parseStr(conformance::CodingType scod_type) {
       using conformance::CodingType;
 
+      require(sizeof(uint16_t));
       const auto len = endian::read<uint16_t>(payload_, BigEndian);
       // this is a definite parse exception
       // handle this separetely because we are doing allocation below 
@@ -140,6 +186,7 @@ namespace dlt {
         throw except::parse_exception("INFO_STRG len is 0");
       }
       payload_ += sizeof(len);
+      require(len);
 
       // remember offset and increase output size: len + space (instead of null-byte)
       const auto offset = std::size(output_);
@@ -168,13 +215,14 @@ namespace dlt {
     void parseRaw() {
       constexpr char hexLiterals[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
 
+      require(sizeof(uint16_t));
       const auto len = endian::read<uint16_t>(payload_, BigEndian);
       payload_ += sizeof(len);
+      require(len);
 
-      // remember offset and increase output size
+      // remember offset and increase output size (the separator is appended by the constructor)
       const auto offset = std::size(output_);
-      //including ' ' after arg
-      output_.resize(std::size(output_) + len * 2 + 1);
+      output_.resize(std::size(output_) + len * 2);
 
       /* convert raw data to hex */
       for (size_t i = 0; i < len; ++i) {
@@ -194,91 +242,194 @@ namespace dlt {
 
     template <typename T, Radix R = Radix::DEC>
     void parseTyle() {
+      require(sizeof(T));
       const auto val = endian::extract<T>(payload_, BigEndian);
-      // constexpr optimization is still poor... let's help our compiler
-      if constexpr (R == Radix::HEX) {
-        fmt::format_to(std::back_inserter(output_), "{:#x}", val);
+      // every value is written straight into the string: no iterator adaptors, at most one resize per value
+      if constexpr (std::is_same_v<T, bool>) {
+        output_.append(val ? "true" : "false");
+      }
+      else if constexpr (std::is_floating_point_v<T>) {
+        // shortest representation, the same as fmt's "{}"
+        char buffer[32];
+        const auto end = fmt::format_to_n(buffer, sizeof(buffer), "{}", val).out;
+        output_.append(buffer, end);
+      }
+      else if constexpr (R == Radix::HEX) {
+        appendRadix<4>(val, 'x');
       }
       else if constexpr (R == Radix::BIN) {
-        fmt::format_to(std::back_inserter(output_), "{:#b}", val);
+        appendRadix<1>(val, 'b');
+      }
+      else {
+        // uint8_t/int8_t are printed as numbers
+        char buffer[24];
+        const auto end = std::to_chars(buffer, buffer + sizeof(buffer), val).ptr;
+        output_.append(buffer, end);
       }
-      // unlike std iostream, fmt consider uint8_t as integer and bool as actual bool, hence there is no need to introduce different specifiers here
-      fmt::format_to(std::back_inserter(output_), "{}", val);
     }
 
-    /* parse tyle helper func */
-    template <typename T>
-    void parseTyle(conformance::CodingType scod_type) {
-      using conformance::CodingType;
+    // "0x"/"0b" prefixed digits without leading zeros as fmt's "{:#x}"/"{:#b}" does
+    template <unsigned Bits, typename T>
+    void appendRadix(const T val, const char prefix) {
+      constexpr char digits[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+      constexpr unsigned mask = (1u << Bits) - 1;
 
-      if (scod_type == CodingType::SCOD_HEX) {
-        return parseTyle<T, Radix::HEX>();
+      const auto value = static_cast<std::make_unsigned_t<T>>(val);
+      unsigned width = 1;
+      for (auto rest = value >> Bits; rest != 0; rest >>= Bits) {
+        ++width;
       }
-      if (scod_type == CodingType::SCOD_BIN) {
-        return parseTyle<T, Radix::BIN>();
+
+      const auto offset = std::size(output_);
+      output_.resize(offset + 2 + width);
+      auto out = std::data(output_) + offset;
+      out[0] = '0';
+      out[1] = prefix;
+      auto rest = value;
+      for (auto i = width; i > 0; --i, rest >>= Bits) {
+        out[1 + i] = digits[rest & mask];
       }
-      return parseTyle<T>();
     }
 
-    /* parse unsigned int */
-    void parseUInt(conformance::TyleType tyle_type, conformance::CodingType scod_type) {
-      using conformance::TyleType;
+    /* compile-time dispatch by the type info word */
+
+    // what the argument type flags (bits 4-14) mean, resolved in the order DLT viewer checks them
+    enum class Kind : uint8_t {
+      Unknown,
+      String,
+      VariableString,
+      UInt,
+      SInt,
+      Float,
+      Bool,
+      Raw,
+      Unsupported,
+      Count
+    };
 
-      switch (tyle_type) {
-      case TyleType::TYLE_8BIT:
-        return parseTyle<uint8_t>(scod_type);
-      case TyleType::TYLE_16BIT:
-        return parseTyle<uint16_t>(scod_type);
-      case TyleType::TYLE_32BIT:
-        return parseTyle<uint32_t>(scod_type);
-      case TyleType::TYLE_64BIT:
-        return parseTyle<uint64_t>(scod_type);
-      case TyleType::TYLE_128BIT:
-        throw except::parse_exception("not supported yet");
-      default:
-        throw except::parse_exception("unknown tyle type");
+    static constexpr uint32_t KIND_SHIFT = 4;
+    static constexpr uint32_t KIND_MASK = 0x7ff;
+    static constexpr uint32_t CODING_SHIFT = 15;
+
+    static constexpr Kind kindOf(const uint32_t flags) {
+      using conformance::ArgType;
+      const auto has = [flags](const ArgType type) {
+        return (flags & (static_cast<uint32_t>(type) >> KIND_SHIFT)) != 0;
+      };
+
+      if (has(ArgType::INFO_STRG)) {
+        return has(ArgType::INFO_VARI) ? Kind::VariableString : Kind::String;
+      }
+      if (has(ArgType::INFO_UINT)) {
+        return Kind::UInt;
       }
+      if (has(ArgType::INFO_SINT)) {
+        return Kind::SInt;
+      }
+      if (has(ArgType::INFO_FLOA)) {
+        return Kind::Float;
+      }
+      if (has(ArgType::INFO_BOOL)) {
+        return Kind::Bool;
+      }
+      if (has(ArgType::INFO_RAWD)) {
+        return Kind::Raw;
+      }
+      if (has(ArgType::INFO_FIXP) || has(ArgType::INFO_TRAI) || has(ArgType::INFO_STRU)) {
+        return Kind::Unsupported;
+      }
+      return Kind::Unknown;
     }
 
-    /* parse signed int */
-    void parseSInt(conformance::TyleType tyle_type) {
-      using conformance::TyleType;
+    // kind, coding (3 bits) and tyle (4 bits) of the type info word
+    static constexpr std::size_t decoderIndex(const Kind kind, const uint32_t type) {
+      return static_cast<std::size_t>(kind) << 7 | ((type >> CODING_SHIFT) & 0x7) << 4 | (type & 0xf);
+    }
 
-      switch (tyle_type) {
-      case TyleType::TYLE_8BIT:
-        return parseTyle<int8_t>();
-      case TyleType::TYLE_16BIT:
-        return parseTyle<int16_t>();
-      case TyleType::TYLE_32BIT:
-        return parseTyle<int32_t>();
-      case TyleType::TYLE_64BIT:
-        return parseTyle<int64_t>();
-      case TyleType::TYLE_128BIT:
-        throw except::parse_exception("not supported yet");
-      default:
-        throw except::parse_exception("unknown tyle type");
-      }
+    template <std::size_t... I>
+    static constexpr auto makeKinds(std::index_sequence<I...>) {
+      return std::array<Kind, sizeof...(I)>{ kindOf(I)... };
     }
 
-    void parseFloat(conformance::TyleType tyle_type) {
+    inline static constexpr auto KINDS = makeKinds(std::make_index_sequence<KIND_MASK + 1>{});
+
+    /* fully specialized decoder of every (kind, coding, tyle) */
+    template <std::size_t Index>
+    static void decode(ArgParser& parser) {
+      using conformance::CodingType;
       using conformance::TyleType;
+      constexpr auto kind = static_cast<Kind>(Index >> 7);
+      constexpr auto coding = static_cast<CodingType>(((Index >> 4) & 0x7) << CODING_SHIFT);
+      constexpr auto tyle = static_cast<TyleType>(Index & 0xf);
+      constexpr auto radix = coding == CodingType::SCOD_HEX ? Radix::HEX : coding == CodingType::SCOD_BIN ? Radix::BIN : Radix::DEC;
 
-      switch (tyle_type) {
-      case TyleType::TYLE_32BIT:
-        return parseTyle<float>();
-      case TyleType::TYLE_64BIT:
-        return parseTyle<double>();
-      default:
-        throw except::parse_exception("unknown tyle type");
+      if constexpr (kind == Kind::String) {
+        parser.parseStr(coding);
+      }
+      else if constexpr (kind == Kind::VariableString) {
+        throw except::parse_exception("how could string be variable?");
+      }
+      else if constexpr (kind == Kind::UInt || kind == Kind::SInt) {
+        constexpr bool isSigned = kind == Kind::SInt;
+        // coding is only honoured for unsigned values
+        constexpr auto r = isSigned ? Radix::DEC : radix;
+        if constexpr (tyle == TyleType::TYLE_8BIT) {
+          parser.parseTyle<std::conditional_t<isSigned, int8_t, uint8_t>, r>();
+        }
+        else if constexpr (tyle == TyleType::TYLE_16BIT) {
+          parser.parseTyle<std::conditional_t<isSigned, int16_t, uint16_t>, r>();
+        }
+        else if constexpr (tyle == TyleType::TYLE_32BIT) {
+          parser.parseTyle<std::conditional_t<isSigned, int32_t, uint32_t>, r>();
+        }
+        else if constexpr (tyle == TyleType::TYLE_64BIT) {
+          parser.parseTyle<std::conditional_t<isSigned, int64_t, uint64_t>, r>();
+        }
+        else if constexpr (tyle == TyleType::TYLE_128BIT) {
+          throw except::parse_exception("not supported yet");
+        }
+        else {
+          throw except::parse_exception("unknown tyle type");
+        }
+      }
+      else if constexpr (kind == Kind::Float) {
+        if constexpr (tyle == TyleType::TYLE_32BIT) {
+          parser.parseTyle<float>();
+        }
+        else if constexpr (tyle == TyleType::TYLE_64BIT) {
+          parser.parseTyle<double>();
+        }
+        else {
+          throw except::parse_exception("unknown tyle type");
+        }
+      }
+      else if constexpr (kind == Kind::Bool) {
+        parser.parseTyle<bool>();
+      }
+      else if constexpr (kind == Kind::Raw) {
+        parser.parseRaw();
+      }
+      else if constexpr (kind == Kind::Unsupported) {
+        throw except::parse_exception("not supported yet");
+      }
+      else {
+        throw except::parse_exception("unknown argument type");
       }
     }
 
-    void parseBool() {
-      parseTyle<bool>();
+    using decoder = void (*)(ArgParser&);
+
+    template <std::size_t... I>
+    static constexpr auto makeDecoders(std::index_sequence<I...>) {
+      return std::array<decoder, sizeof...(I)>{ &decode<I>... };
     }
 
+    inline static constexpr auto DECODERS = makeDecoders(
+      std::make_index_sequence<decoderIndex(Kind::Count, 0)>{});
+
   private:
     const uint8_t* payload_;
-    std::string output_;
+    const uint8_t* end_;
+    std::string& output_;
   };
 }
@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "background_parse.h"
+
+namespace dlt {
+  background_parse::background_parse(fs::reader&& reader, const parse_options& options, const unsigned threads_num,
+    const std::size_t chunk_size) : len_(reader.get_len()), supervisor_(std::move(reader), options, threads_num, chunk_size) {
+    thread_ = std::thread(&background_parse::run, this);
+  }
+
+  background_parse::~background_parse() {
+    supervisor_.cancel();
+    thread_.join();
+  }
+
+  void background_parse::run() noexcept {
+    std::size_t end = 0;
+    std::exception_ptr error;
+    try {
+      end = supervisor_.execute(table_, mutex_, [this](const std::size_t covered) {
+        // under the lock: a reader must not miss the wake-up between its check and its wait
+        {
+          std::lock_guard lock(mutex_);
+          rows_ = table_.size();
+          covered_ = covered;
+        }
+        stitched_.notify_all();
+      });
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard lock(mutex_);
+      end_ = end;
+      error_ = error;
+      done_ = true;
+    }
+    stitched_.notify_all();
+  }
+
+  std::size_t background_parse::size() const noexcept {
+    return rows_;
+  }
+
+  std::optional<Record> background_parse::get(const std::size_t index) const {
+    std::unique_lock lock(mutex_);
+    stitched_.wait(lock, [this, index]() { return index < rows_ || done_; });
+    if (index >= rows_) {
+      return std::nullopt;
+    }
+    return table_.get(index);
+  }
+
+  double background_parse::progress() const noexcept {
+    if (done_) {
+      return 1.0;
+    }
+    return len_ == 0 ? 0.0 : static_cast<double>(std::min<std::size_t>(covered_, len_)) / static_cast<double>(len_);
+  }
+
+  bool background_parse::done() const noexcept {
+    return done_;
+  }
+
+  std::size_t background_parse::finish(SegmentedTable& records) {
+    {
+      std::unique_lock lock(mutex_);
+      stitched_.wait(lock, [this]() { return done_.load(); });
+    }
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+    records = std::move(table_);
+    table_ = {};
+    rows_ = 0;
+    return end_;
+  }
+
+  parse_stats background_parse::stats() const {
+    std::unique_lock lock(mutex_);
+    stitched_.wait(lock, [this]() { return done_.load(); });
+    return supervisor_.stats();
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "record.h"
+#include "segmented_table.h"
+#include "thread_supervisor.h"
+#include "filereader.h"
+#include "stats.h"
+
+namespace dlt {
+  // supervisor running in a thread of its own. the caller may read the records already stitched meanwhile:
+  // they are a file-ordered prefix of the result which only grows (see supervisor::execute with stitched)
+  class background_parse final {
+  public:
+    // the arguments are the same as of supervisor. parsing starts right away
+    explicit background_parse(fs::reader&& reader, const parse_options& options = {}, unsigned threads_num = 0,
+      std::size_t chunk_size = supervisor::DEFAULT_CHUNK_SIZE);
+    background_parse(const background_parse&) = delete;
+    background_parse& operator=(const background_parse&) = delete;
+    // cancels the parse if it is still running
+    ~background_parse();
+
+    // records available so far
+    [[nodiscard]] std::size_t size() const noexcept;
+    // waits until the record is available. nullopt if the parse ended (or failed) before reaching it
+    [[nodiscard]] std::optional<Record> get(std::size_t index) const;
+    // fraction of the file covered so far, 1 once done
+    [[nodiscard]] double progress() const noexcept;
+    [[nodiscard]] bool done() const noexcept;
+
+    // waits for the end and hands over all the records. rethrows the exception the parse failed with
+    // returns the offset parsing ended at as supervisor::execute does
+    std::size_t finish(SegmentedTable& records);
+    [[nodiscard]] parse_stats stats() const;
+
+  private:
+    void run() noexcept;
+
+    const std::size_t len_;
+    supervisor supervisor_;
+
+    // guards table_ and wakes up the readers waiting for a record
+    mutable std::mutex mutex_;
+    mutable std::condition_variable stitched_;
+    SegmentedTable table_;
+    std::atomic<std::size_t> rows_{ 0 };
+    std::atomic<std::size_t> covered_{ 0 };
+    std::atomic<bool> done_{ false };
+    std::size_t end_{ 0 };
+    std::exception_ptr error_;
+
+    std::thread thread_;
+  };
+}
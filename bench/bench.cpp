@@ -0,0 +1,475 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+#include "../argparser.h"
+#include "../filereader.h"
+#include "../filter.h"
+#include "../record.h"
+#include "../segmented_table.h"
+#include "../thread_supervisor.h"
+#include "generator.h"
+
+/* for lld */
+#ifdef __llvm__
+# pragma comment(lib, "fmt")
+#	pragma comment(lib, "boost_iostreams-vc140-mt")
+# ifdef DLT_WITH_GZIP
+#  pragma comment(lib, "zlib")
+# endif
+# ifdef DLT_WITH_XZ
+#  pragma comment(lib, "lzma")
+# endif
+# ifdef DLT_WITH_ZSTD
+#  pragma comment(lib, "zstd")
+# endif
+#endif
+
+// bench generate <file> [--records N] [--non-verbose share] [--control share] [--big-endian share]
+//                       [--corruption share] [--max-args N] [--seed N]
+// bench run <file> [--threads 1,2,4] [--repeat N] [--lazy] [--chunk bytes]
+// bench format [--messages N] [--repeat N] [--check N] [--seed N]
+// bench filter <file> [--filter expression] [--text substring] [--lazy] [--threads N]
+namespace {
+  constexpr std::string_view USAGE =
+    "usage:\n"
+    "  bench generate <file> [--records N] [--non-verbose share] [--control share] [--big-endian share]\n"
+    "                        [--corruption share] [--max-args N] [--seed N]\n"
+    "  bench run <file> [--threads 1,2,4] [--repeat N] [--lazy] [--chunk bytes]\n"
+    "  bench format [--messages N] [--repeat N] [--check N] [--seed N]\n"
+    "  bench filter <file> [--filter expression] [--text substring] [--lazy] [--threads N]\n"
+    "      compares the parse with the filter pushed down against a full parse filtered afterwards\n";
+
+  class arguments final {
+  public:
+    arguments(const int argc, char** argv) : args_(argv, argv + argc) {
+    }
+
+    [[nodiscard]] bool flag(const std::string_view name) const {
+      for (const auto& arg : args_) {
+        if (std::string_view(arg) == name) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    [[nodiscard]] const char* value(const std::string_view name) const {
+      for (std::size_t i = 0; i + 1 < args_.size(); ++i) {
+        if (std::string_view(args_[i]) == name) {
+          return args_[i + 1];
+        }
+      }
+      return nullptr;
+    }
+
+    [[nodiscard]] double number(const std::string_view name, const double fallback) const {
+      const auto str = value(name);
+      return str ? std::strtod(str, nullptr) : fallback;
+    }
+
+    [[nodiscard]] std::vector<unsigned> list(const std::string_view name, std::vector<unsigned> fallback) const {
+      const auto str = value(name);
+      if (!str) {
+        return fallback;
+      }
+      std::vector<unsigned> result;
+      for (const char* it = str;; ++it) {
+        char* end;
+        const auto num = std::strtoul(it, &end, 10);
+        if (end == it) {
+          break;
+        }
+        result.push_back(static_cast<unsigned>(num));
+        if (*end != ',') {
+          break;
+        }
+        it = end;
+      }
+      return result;
+    }
+
+  private:
+    std::vector<const char*> args_;
+  };
+
+  int generate(const std::filesystem::path& path, const arguments& args) {
+    dlt::bench::generator_options options;
+    options.records = static_cast<std::size_t>(args.number("--records", static_cast<double>(options.records)));
+    options.non_verbose = args.number("--non-verbose", options.non_verbose);
+    options.control = args.number("--control", options.control);
+    options.big_endian = args.number("--big-endian", options.big_endian);
+    options.corruption = args.number("--corruption", options.corruption);
+    options.max_args = static_cast<unsigned>(args.number("--max-args", options.max_args));
+    options.seed = static_cast<uint64_t>(args.number("--seed", static_cast<double>(options.seed)));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto bytes = dlt::bench::generate(path, options);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << fmt::format("{}: {} records, {:.1f} MB in {:.2f} s\n",
+      path.string(), options.records, static_cast<double>(bytes) / 1e6, elapsed.count());
+    return 0;
+  }
+
+  int run(const std::filesystem::path& path, const arguments& args) {
+    const auto threads = args.list("--threads", { 1, 2, 4, dlt::supervisor::cores_num });
+    const auto repeat = static_cast<unsigned>(args.number("--repeat", 3));
+    const auto chunk = static_cast<std::size_t>(args.number("--chunk", dlt::supervisor::DEFAULT_CHUNK_SIZE));
+    dlt::parse_options options;
+    options.lazy_message = args.flag("--lazy");
+
+    const auto size = static_cast<double>(std::filesystem::file_size(path));
+    constexpr std::pair<dlt::fs::reader_type, std::string_view> readers[] = {
+      { dlt::fs::reader_type::file_precache, "file_precache" },
+      { dlt::fs::reader_type::file_map, "file_map" },
+    };
+
+    std::cout << fmt::format("{:<14} {:>7} {:>10} {:>12} {:>10}\n", "reader", "threads", "MB/s", "records/s", "records");
+    for (const auto& [type, name] : readers) {
+      for (const auto num : threads) {
+        // the best of the runs: the first one of each reader also pays for the page cache
+        double best = 0;
+        std::size_t records = 0;
+        for (unsigned i = 0; i != std::max(repeat, 1u); ++i) {
+          const auto start = std::chrono::steady_clock::now();
+          auto&& reader = dlt::fs::reader::factory(type, path);
+          dlt::SegmentedTable table;
+          dlt::supervisor(std::move(*reader), options, num, chunk).execute(table);
+          const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+          records = table.size();
+          if (best == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+          }
+        }
+        std::cout << fmt::format("{:<14} {:>7} {:>10.1f} {:>12.0f} {:>10}\n",
+          name, num, size / 1e6 / best, static_cast<double>(records) / best, records);
+      }
+    }
+    return 0;
+  }
+
+  /* bench filter: parse_options::filter must select the same records as a full parse filtered afterwards */
+
+  struct filtered_record {
+    dlt::RecordTable::microseconds time;
+    std::string apid;
+    std::string ctid;
+    std::string message;
+
+    bool operator==(const filtered_record& other) const = default;
+  };
+
+  // records which are not corrupted. corruption markers of a filtered parse may merge: skipped records are not kept
+  std::vector<filtered_record> select(const dlt::SegmentedTable& table, const dlt::record_filter* filter) {
+    using dlt::record_filter;
+    std::vector<filtered_record> records;
+    for (std::size_t i = 0; i != table.size(); ++i) {
+      const auto record = table.get(i);
+      if (record.isCorrupted()) {
+        continue;
+      }
+      const dlt::filter_fields fields{ record_filter::make_id(record.getEcu()), record_filter::make_id(record.getApid()),
+        record_filter::make_id(record.getCtid()), record.getType(), record.getSubType(), record.getTimeStamp() };
+      const auto message = record.getMessageView();
+      if (filter == nullptr || (filter->matches(fields)
+        && (filter->text.empty() || message.find(filter->text) != std::string_view::npos))) {
+        records.push_back({ fields.time, std::string(record.getApid()), std::string(record.getCtid()), std::string(message) });
+      }
+    }
+    return records;
+  }
+
+  int filter(const std::filesystem::path& path, const arguments& args) {
+    const auto threads = static_cast<unsigned>(args.number("--threads", dlt::supervisor::cores_num));
+    auto filter = std::make_shared<dlt::record_filter>();
+    if (const auto expression = args.value("--filter")) {
+      filter->expression = dlt::filter_expression::compile(expression);
+    }
+    if (const auto text = args.value("--text")) {
+      filter->text = text;
+    }
+
+    const auto parse = [&](std::shared_ptr<const dlt::record_filter> pushed, double& elapsed) {
+      dlt::parse_options options;
+      options.lazy_message = args.flag("--lazy");
+      options.filter = std::move(pushed);
+      const auto start = std::chrono::steady_clock::now();
+      auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path);
+      auto table = std::make_unique<dlt::SegmentedTable>();
+      dlt::supervisor(std::move(*reader), options, threads).execute(*table);
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return table;
+    };
+
+    double pushed_time = 0;
+    double full_time = 0;
+    const auto pushed = select(*parse(filter, pushed_time), nullptr);
+    const auto expected = select(*parse(nullptr, full_time), filter.get());
+    std::cout << fmt::format("pushed down {:>10} records in {:.3f} s\n", pushed.size(), pushed_time);
+    std::cout << fmt::format("filtered    {:>10} records in {:.3f} s (the full parse)\n", expected.size(), full_time);
+
+    const auto [mismatch, _] = std::mismatch(pushed.cbegin(), pushed.cend(), expected.cbegin(), expected.cend());
+    if (mismatch == pushed.cend() && pushed.size() == expected.size()) {
+      return 0;
+    }
+    const auto index = static_cast<std::size_t>(mismatch - pushed.cbegin());
+    const auto describe = [](const std::vector<filtered_record>& records, const std::size_t i) {
+      return i < records.size()
+        ? fmt::format("{} {} {} {}", records[i].time, records[i].apid, records[i].ctid, records[i].message) : "none";
+    };
+    std::cout << fmt::format("record {} differs:\n  pushed down {}\n  filtered    {}\n", index,
+      describe(pushed, index), describe(expected, index));
+    return 1;
+  }
+
+  /* bench format: ArgParser alone on numeric-heavy messages and a cross-check of its output against fmt */
+
+  using dlt::conformance::ArgType;
+  using dlt::conformance::CodingType;
+  using dlt::conformance::TyleType;
+
+  constexpr uint32_t type_info(const ArgType type, const TyleType tyle, const CodingType coding = CodingType::SCOD_ASCII) {
+    return static_cast<uint32_t>(type) | static_cast<uint32_t>(tyle) | static_cast<uint32_t>(coding);
+  }
+
+  template <typename T>
+  void append(std::vector<uint8_t>& payload, const T value) {
+    uint8_t bytes[sizeof(T)];
+    ::memcpy(bytes, &value, sizeof(T));
+    payload.insert(payload.end(), bytes, bytes + sizeof(T));
+  }
+
+  // a verbose little endian payload of one argument
+  template <typename T>
+  std::string format_one(const uint32_t type, const T value) {
+    std::vector<uint8_t> payload;
+    append(payload, type);
+    append(payload, value);
+    std::string output;
+    dlt::ArgParser<false>(payload.data(), payload.data() + payload.size(), 1, output);
+    return output;
+  }
+
+  // formatting through fmt::format_to with std::back_inserter (as parseTyle did it before), the reference
+  // of the timings: the same values, separated the same way
+  struct reference_value {
+    enum class kind : uint8_t { dec, hex, bin, sint, floa } type;
+    uint64_t bits;
+  };
+
+  void format_reference(const std::vector<reference_value>& values, const std::size_t begin, const std::size_t end,
+    std::string& output) {
+    for (auto i = begin; i != end; ++i) {
+      if (i != begin) {
+        output.push_back(' ');
+      }
+      const auto [type, bits] = values[i];
+      switch (type) {
+      case reference_value::kind::dec:
+        fmt::format_to(std::back_inserter(output), "{}", bits);
+        break;
+      case reference_value::kind::hex:
+        fmt::format_to(std::back_inserter(output), "{:#x}", bits);
+        break;
+      case reference_value::kind::bin:
+        fmt::format_to(std::back_inserter(output), "{:#b}", bits);
+        break;
+      case reference_value::kind::sint:
+        fmt::format_to(std::back_inserter(output), "{}", static_cast<int32_t>(bits));
+        break;
+      case reference_value::kind::floa: {
+        double value;
+        ::memcpy(&value, &bits, sizeof(value));
+        fmt::format_to(std::back_inserter(output), "{}", value);
+        break;
+      }
+      }
+    }
+  }
+
+  // values of every numeric type in every radix against fmt's "{}", "{:#x}" and "{:#b}". returns the mismatches
+  std::size_t check_format(const std::size_t num, std::mt19937_64& random) {
+    std::size_t mismatches = 0;
+    const auto check = [&mismatches](const std::string& formatted, const std::string& expected) {
+      if (formatted != expected && mismatches++ < 10) {
+        std::cout << fmt::format("  '{}' instead of '{}'\n", formatted, expected);
+      }
+    };
+
+    for (std::size_t i = 0; i != num; ++i) {
+      // all the magnitudes are equally likely
+      const auto value = random() >> (random() % 64);
+      const auto u8 = static_cast<uint8_t>(value);
+      const auto u16 = static_cast<uint16_t>(value);
+      const auto u32 = static_cast<uint32_t>(value);
+      for (const auto coding : { CodingType::SCOD_ASCII, CodingType::SCOD_HEX, CodingType::SCOD_BIN }) {
+        const auto expected = [coding](const auto unsigned_value) {
+          switch (coding) {
+          case CodingType::SCOD_HEX:
+            return fmt::format("{:#x}", unsigned_value);
+          case CodingType::SCOD_BIN:
+            return fmt::format("{:#b}", unsigned_value);
+          default:
+            return fmt::format("{}", unsigned_value);
+          }
+        };
+        check(format_one(type_info(ArgType::INFO_UINT, TyleType::TYLE_8BIT, coding), u8), expected(u8));
+        check(format_one(type_info(ArgType::INFO_UINT, TyleType::TYLE_16BIT, coding), u16), expected(u16));
+        check(format_one(type_info(ArgType::INFO_UINT, TyleType::TYLE_32BIT, coding), u32), expected(u32));
+        check(format_one(type_info(ArgType::INFO_UINT, TyleType::TYLE_64BIT, coding), value), expected(value));
+      }
+      check(format_one(type_info(ArgType::INFO_SINT, TyleType::TYLE_8BIT), static_cast<int8_t>(u8)),
+        fmt::format("{}", static_cast<int8_t>(u8)));
+      check(format_one(type_info(ArgType::INFO_SINT, TyleType::TYLE_16BIT), static_cast<int16_t>(u16)),
+        fmt::format("{}", static_cast<int16_t>(u16)));
+      check(format_one(type_info(ArgType::INFO_SINT, TyleType::TYLE_32BIT), static_cast<int32_t>(u32)),
+        fmt::format("{}", static_cast<int32_t>(u32)));
+      check(format_one(type_info(ArgType::INFO_SINT, TyleType::TYLE_64BIT), static_cast<int64_t>(value)),
+        fmt::format("{}", static_cast<int64_t>(value)));
+
+      float f;
+      ::memcpy(&f, &u32, sizeof(f));
+      double d;
+      ::memcpy(&d, &value, sizeof(d));
+      check(format_one(type_info(ArgType::INFO_FLOA, TyleType::TYLE_32BIT), f), fmt::format("{}", f));
+      check(format_one(type_info(ArgType::INFO_FLOA, TyleType::TYLE_64BIT), d), fmt::format("{}", d));
+      check(format_one(type_info(ArgType::INFO_BOOL, TyleType::TYLE_8BIT), static_cast<uint8_t>(u8 & 1)),
+        fmt::format("{}", static_cast<bool>(u8 & 1)));
+    }
+    return mismatches;
+  }
+
+  int format(const arguments& args) {
+    constexpr std::size_t ARGS_NUM = 10;
+    const auto messages = static_cast<std::size_t>(args.number("--messages", 10000));
+    const auto repeat = static_cast<unsigned>(args.number("--repeat", 30));
+    const auto check_num = static_cast<std::size_t>(args.number("--check", 200000));
+    std::mt19937_64 random(static_cast<uint64_t>(args.number("--seed", 1)));
+
+    // sensor dump like messages: ARGS_NUM numeric arguments of dec/hex/bin/int/u64/double
+    std::vector<std::vector<uint8_t>> payloads(messages);
+    std::vector<reference_value> values;
+    values.reserve(messages * ARGS_NUM);
+    for (auto& payload : payloads) {
+      for (std::size_t i = 0; i != ARGS_NUM; ++i) {
+        const auto value = static_cast<uint32_t>(random());
+        switch (i % 6) {
+        case 0:
+          append(payload, type_info(ArgType::INFO_UINT, TyleType::TYLE_32BIT));
+          append(payload, value);
+          values.push_back({ reference_value::kind::dec, value });
+          break;
+        case 1:
+          append(payload, type_info(ArgType::INFO_UINT, TyleType::TYLE_32BIT, CodingType::SCOD_HEX));
+          append(payload, value);
+          values.push_back({ reference_value::kind::hex, value });
+          break;
+        case 2:
+          append(payload, type_info(ArgType::INFO_UINT, TyleType::TYLE_32BIT, CodingType::SCOD_BIN));
+          append(payload, value);
+          values.push_back({ reference_value::kind::bin, value });
+          break;
+        case 3:
+          append(payload, type_info(ArgType::INFO_SINT, TyleType::TYLE_32BIT));
+          append(payload, value);
+          values.push_back({ reference_value::kind::sint, value });
+          break;
+        case 4: {
+          const auto wide = static_cast<uint64_t>(value) * value;
+          append(payload, type_info(ArgType::INFO_UINT, TyleType::TYLE_64BIT));
+          append(payload, wide);
+          values.push_back({ reference_value::kind::dec, wide });
+          break;
+        }
+        default: {
+          const auto real = value / 7.0;
+          uint64_t bits;
+          ::memcpy(&bits, &real, sizeof(bits));
+          append(payload, type_info(ArgType::INFO_FLOA, TyleType::TYLE_64BIT));
+          append(payload, real);
+          values.push_back({ reference_value::kind::floa, bits });
+          break;
+        }
+        }
+      }
+    }
+
+    // the output buffer is reused as RecordTable does it
+    const auto measure = [&](auto&& format_message) {
+      std::string output;
+      double best = 0;
+      std::size_t bytes = 0;
+      for (unsigned r = 0; r != std::max(repeat, 1u); ++r) {
+        bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i != messages; ++i) {
+          output.clear();
+          format_message(i, output);
+          bytes += output.size();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (best == 0 || elapsed.count() < best) {
+          best = elapsed.count();
+        }
+      }
+      std::cout << fmt::format("{:>10.1f} {:>10.1f}\n", best * 1e9 / static_cast<double>(messages),
+        static_cast<double>(bytes) / 1e6 / best);
+    };
+
+    std::cout << fmt::format("{:<24} {:>10} {:>10}\n", "formatting", "ns/msg", "MB/s");
+    std::cout << fmt::format("{:<24} ", "ArgParser");
+    measure([&payloads](const std::size_t i, std::string& output) {
+      const auto& payload = payloads[i];
+      dlt::ArgParser<false>(payload.data(), payload.data() + payload.size(), ARGS_NUM, output);
+    });
+    std::cout << fmt::format("{:<24} ", "fmt back_inserter");
+    measure([&values](const std::size_t i, std::string& output) {
+      format_reference(values, i * ARGS_NUM, (i + 1) * ARGS_NUM, output);
+    });
+
+    const auto mismatches = check_format(check_num, random);
+    std::cout << fmt::format("check: {} values of every type, {} mismatches\n", check_num, mismatches);
+    return mismatches == 0 ? 0 : 1;
+  }
+}
+
+int main(const int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << USAGE;
+    return 2;
+  }
+
+  const std::string_view command = argv[1];
+  const arguments args(argc, argv);
+  try {
+    if (command == "generate" && argc >= 3) {
+      return generate(argv[2], args);
+    }
+    if (command == "run" && argc >= 3) {
+      return run(argv[2], args);
+    }
+    if (command == "format") {
+      return format(args);
+    }
+    if (command == "filter" && argc >= 3) {
+      return filter(argv[2], args);
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  std::cerr << USAGE;
+  return 2;
+}
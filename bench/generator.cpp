@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include "generator.h"
+
+namespace dlt::bench {
+  namespace {
+    /* htyp */
+    constexpr uint8_t UEH = 0x01;
+    constexpr uint8_t MSBF = 0x02;
+    constexpr uint8_t WEID = 0x04;
+    constexpr uint8_t WTMS = 0x10;
+    constexpr uint8_t VERSION_1 = 0x20;
+
+    /* msin */
+    constexpr uint8_t VERBOSE = 0x01;
+    constexpr uint8_t TYPE_LOG = 0;
+    constexpr uint8_t TYPE_CONTROL = 3;
+    constexpr uint8_t CONTROL_RESPONSE = 2;
+
+    /* control service ids */
+    constexpr uint32_t GET_SOFTWARE_VERSION = 19;
+    constexpr uint32_t CONNECTION_INFO = 0xf02;
+    constexpr uint32_t CONTROL_SERVICES[] = { 1, 2, 4, 5, 9, 12, GET_SOFTWARE_VERSION, CONNECTION_INFO, 0xf04 };
+
+    /* type info */
+    constexpr uint32_t BOOL = 0x10;
+    constexpr uint32_t SINT = 0x20;
+    constexpr uint32_t UINT = 0x40;
+    constexpr uint32_t FLOA = 0x80;
+    constexpr uint32_t STRG = 0x200;
+    constexpr uint32_t RAWD = 0x400;
+    constexpr uint32_t SCOD_HEX = 0x10000;
+    constexpr uint32_t SCOD_BIN = 0x18000;
+
+    constexpr const char* IDS[] = { "APP", "DIAG", "SYS", "NET", "CTX1", "MAIN", "IO", "SENS" };
+    constexpr const char* WORDS[] = { "timeout", "connected", "value", "state", "retry", "sensor", "frame", "ok" };
+
+    class writer final {
+    public:
+      explicit writer(const bool bigEndian) : bigEndian_(bigEndian) {
+      }
+
+      void id(const char* value) {
+        const std::string str(value);
+        for (std::size_t i = 0; i != 4; ++i) {
+          bytes.push_back(i < str.size() ? static_cast<uint8_t>(str[i]) : 0);
+        }
+      }
+
+      template <typename T>
+      void value(const T value, const bool bigEndian) {
+        uint8_t raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        if (bigEndian) {
+          std::reverse(raw, raw + sizeof(T));
+        }
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+      }
+
+      // in the endianness of the payload
+      template <typename T>
+      void value(const T value) {
+        this->value(value, bigEndian_);
+      }
+
+      std::vector<uint8_t> bytes;
+
+    private:
+      bool bigEndian_;
+    };
+
+    void argument(writer& payload, std::mt19937_64& random) {
+      switch (random() % 7) {
+      case 0: {
+        const std::string str = WORDS[random() % std::size(WORDS)] + std::to_string(random() % 1000);
+        payload.value(STRG);
+        payload.value(static_cast<uint16_t>(str.size() + 1));
+        payload.bytes.insert(payload.bytes.end(), str.begin(), str.end());
+        payload.bytes.push_back(0);
+        break;
+      }
+      case 1: {
+        // tyle 1..4 with any coding
+        const auto tyle = static_cast<uint32_t>(random() % 4 + 1);
+        const uint32_t codings[] = { 0, SCOD_HEX, SCOD_BIN };
+        payload.value(UINT | tyle | codings[random() % 3]);
+        const auto value = random();
+        switch (tyle) {
+        case 1: payload.value(static_cast<uint8_t>(value)); break;
+        case 2: payload.value(static_cast<uint16_t>(value)); break;
+        case 3: payload.value(static_cast<uint32_t>(value)); break;
+        default: payload.value(value); break;
+        }
+        break;
+      }
+      case 2:
+        payload.value(SINT | 3);
+        payload.value(static_cast<int32_t>(random()));
+        break;
+      case 3:
+        payload.value(FLOA | 4);
+        payload.value(static_cast<double>(random() % 1'000'000) / 7.0);
+        break;
+      case 4:
+        payload.value(FLOA | 3);
+        payload.value(static_cast<float>(random() % 1000) / 3.0f);
+        break;
+      case 5:
+        payload.value(BOOL | 1);
+        payload.value(static_cast<uint8_t>(random() % 2));
+        break;
+      default: {
+        const auto len = static_cast<uint16_t>(random() % 16 + 1);
+        payload.value(RAWD);
+        payload.value(len);
+        for (uint16_t i = 0; i != len; ++i) {
+          payload.bytes.push_back(static_cast<uint8_t>(random()));
+        }
+        break;
+      }
+      }
+    }
+  }
+
+  std::size_t generate(const std::filesystem::path& path, const generator_options& options) {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os) {
+      throw std::runtime_error("unable to create " + path.string());
+    }
+
+    std::mt19937_64 random(options.seed);
+    std::uniform_real_distribution<double> share(0.0, 1.0);
+    std::size_t written = 0;
+
+    for (std::size_t i = 0; i != options.records; ++i) {
+      const bool bigEndian = share(random) < options.big_endian;
+      const auto kind = share(random);
+      const bool control = kind < options.control;
+      const bool verbose = !control && kind >= options.control + options.non_verbose;
+
+      writer payload(bigEndian);
+      uint8_t noar = 0;
+      uint8_t msin;
+      if (control) {
+        // responses of a few common services, the ones with data carry a valid body
+        const auto service = CONTROL_SERVICES[random() % std::size(CONTROL_SERVICES)];
+        payload.value(service);
+        payload.bytes.push_back(0);
+        if (service == GET_SOFTWARE_VERSION) {
+          // the length is read as little-endian regardless of the message
+          const std::string version = "bench " + std::to_string(random() % 100);
+          payload.value(static_cast<uint32_t>(version.size()), false);
+          payload.bytes.insert(payload.bytes.end(), version.begin(), version.end());
+        }
+        else if (service == CONNECTION_INFO) {
+          payload.bytes.push_back(static_cast<uint8_t>(random() % 2 + 1));
+          payload.id("ECU1");
+        }
+        msin = static_cast<uint8_t>(TYPE_CONTROL << 1 | CONTROL_RESPONSE << 4);
+      }
+      else if (verbose) {
+        noar = static_cast<uint8_t>(random() % std::max(1u, options.max_args) + 1);
+        for (uint8_t arg = 0; arg != noar; ++arg) {
+          argument(payload, random);
+        }
+        // log levels fatal..verbose
+        msin = static_cast<uint8_t>(VERBOSE | TYPE_LOG << 1 | (random() % 6 + 1) << 4);
+      }
+      else {
+        payload.value(static_cast<uint32_t>(random() % 100000));
+        const auto len = random() % 32;
+        for (std::size_t byte = 0; byte != len; ++byte) {
+          payload.bytes.push_back(static_cast<uint8_t>(random()));
+        }
+        msin = static_cast<uint8_t>(TYPE_LOG << 1 | (random() % 6 + 1) << 4);
+      }
+
+      // standard header fields are always big-endian, the storage header is little-endian
+      writer record(false);
+      record.bytes.insert(record.bytes.end(), { 'D', 'L', 'T', 0x01 });
+      record.value(static_cast<uint32_t>(1'600'000'000 + i / 1000));
+      record.value(static_cast<uint32_t>(i % 1000 * 1000));
+      record.id("ECU1");
+      const auto len = static_cast<uint16_t>(4 + 4 + 4 + 10 + payload.bytes.size());
+      record.bytes.push_back(static_cast<uint8_t>(UEH | WEID | WTMS | VERSION_1 | (bigEndian ? MSBF : 0)));
+      record.bytes.push_back(static_cast<uint8_t>(i));
+      record.value(len, true);
+      record.id("ECU1");
+      record.value(static_cast<uint32_t>(i * 10), true);
+      record.bytes.push_back(msin);
+      record.bytes.push_back(noar);
+      record.id(IDS[random() % 4]);
+      record.id(IDS[4 + random() % 4]);
+      record.bytes.insert(record.bytes.end(), payload.bytes.begin(), payload.bytes.end());
+
+      if (share(random) < options.corruption) {
+        if (random() % 2) {
+          // cut short: the next storage header starts in the middle of the record
+          record.bytes.resize(record.bytes.size() / 2);
+        }
+        else {
+          const auto garbage = random() % 200 + 1;
+          for (std::size_t byte = 0; byte != garbage; ++byte) {
+            record.bytes.push_back(static_cast<uint8_t>(random()));
+          }
+        }
+      }
+
+      os.write(reinterpret_cast<const char*>(record.bytes.data()), static_cast<std::streamsize>(record.bytes.size()));
+      written += record.bytes.size();
+    }
+
+    if (!os.flush()) {
+      throw std::runtime_error("unable to write " + path.string());
+    }
+    return written;
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+// synthetic DLT files for benchmarking. the mix of messages is random but reproducible by the seed
+namespace dlt::bench {
+  struct generator_options {
+    std::size_t records = 1'000'000;
+    // shares of the records, the rest are verbose logs
+    double non_verbose = 0.1;
+    double control = 0.01;
+    // share of records with big-endian payload
+    double big_endian = 0.1;
+    // share of records followed by garbage (or cut short)
+    double corruption = 0.001;
+    // verbose arguments per record are 1..max_args of string/integer (dec/hex/bin)/float/bool/raw
+    unsigned max_args = 6;
+    uint64_t seed = 1;
+  };
+
+  // returns the number of bytes written. throws std::runtime_error if the file cannot be written
+  std::size_t generate(const std::filesystem::path& path, const generator_options& options);
+}
@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <optional>
+#include <string_view>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include "catalog.h"
+#include "argparser.h"
+
+namespace dlt {
+  namespace {
+    using boost::property_tree::ptree;
+
+    /* type info of the arguments (see conformance::ArgType) */
+    constexpr uint32_t TYPE_BOOL = 0x10 | 1;
+    constexpr uint32_t TYPE_SINT = 0x20;
+    constexpr uint32_t TYPE_UINT = 0x40;
+    constexpr uint32_t TYPE_FLOA = 0x80;
+    constexpr uint32_t TYPE_STRG_ASCII = 0x200;
+    constexpr uint32_t TYPE_RAWD = 0x400;
+
+    constexpr std::string_view FRAME_PREFIX = "ID_";
+
+    // the tyle of a width in bits, 0 if there is none
+    constexpr uint32_t tyle(const unsigned bits) {
+      switch (bits) {
+      case 8: return 1;
+      case 16: return 2;
+      case 32: return 3;
+      case 64: return 4;
+      default: return 0;
+      }
+    }
+
+    std::optional<unsigned> number(const std::string_view str) {
+      unsigned value{};
+      const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+      if (ec != std::errc{} || end != str.data() + str.size()) {
+        return std::nullopt;
+      }
+      return value;
+    }
+
+    // the same signal of a width: S_UINT32, A_UINT32 etc. 0 if prefix is not followed by a supported width
+    uint32_t sized(const std::string_view name, const std::string_view prefix, const uint32_t type) {
+      if (name.substr(0, prefix.size()) != prefix) {
+        return 0;
+      }
+      const auto bits = number(name.substr(prefix.size()));
+      return bits && tyle(*bits) ? type | tyle(*bits) : 0;
+    }
+
+    // signal ids DLT viewer understands without looking at their definitions. 0 if the id is not one of them
+    uint32_t signal_type(const std::string_view id) {
+      if (id == "S_BOOL") {
+        return TYPE_BOOL;
+      }
+      if (id == "S_STRG_ASCII") {
+        return TYPE_STRG_ASCII;
+      }
+      if (id == "S_RAWD" || id == "S_RAW") {
+        return TYPE_RAWD;
+      }
+      if (const auto type = sized(id, "S_UINT", TYPE_UINT)) {
+        return type;
+      }
+      if (const auto type = sized(id, "S_SINT", TYPE_SINT)) {
+        return type;
+      }
+      return sized(id, "S_FLOA", TYPE_FLOA);
+    }
+
+    // ASAM base data type of a coding. 0 if unsupported, A_UNICODE2STRING (utf-16) included
+    uint32_t base_type(const std::string_view type) {
+      if (type == "A_ASCIISTRING") {
+        return TYPE_STRG_ASCII;
+      }
+      if (type == "A_BYTEFIELD") {
+        return TYPE_RAWD;
+      }
+      if (const auto result = sized(type, "A_UINT", TYPE_UINT)) {
+        return result;
+      }
+      if (const auto result = sized(type, "A_INT", TYPE_SINT)) {
+        return result;
+      }
+      return sized(type, "A_FLOAT", TYPE_FLOA);
+    }
+
+    /* element names are compared without the namespace prefix: fx:FRAME, ho:SHORT-NAME etc. */
+
+    std::string_view local(const std::string_view name) {
+      const auto colon = name.rfind(':');
+      return colon == std::string_view::npos ? name : name.substr(colon + 1);
+    }
+
+    const ptree* child(const ptree& node, const std::string_view name) {
+      for (const auto& [key, value] : node) {
+        if (local(key) == name) {
+          return &value;
+        }
+      }
+      return nullptr;
+    }
+
+    std::string_view text(const ptree& node, const std::string_view name) {
+      const auto found = child(node, name);
+      return found != nullptr ? std::string_view(found->data()) : std::string_view{};
+    }
+
+    std::string_view attribute(const ptree& node, const std::string_view name) {
+      const auto attributes = node.get_child_optional("<xmlattr>");
+      return attributes ? text(*attributes, name) : std::string_view{};
+    }
+
+    // calls visitor(node) for every element of the name in document order, they are not searched for nested ones
+    template <typename Visitor>
+    void for_each(const ptree& node, const std::string_view name, Visitor&& visitor) {
+      for (const auto& [key, value] : node) {
+        if (key == "<xmlattr>" || key == "<xmlcomment>") {
+          continue;
+        }
+        if (local(key) == name) {
+          visitor(value);
+        }
+        else {
+          for_each(value, name, visitor);
+        }
+      }
+    }
+
+    // ID-REF attributes of the children in the order of their SEQUENCE-NUMBER
+    std::vector<std::string_view> references(const ptree& node, const std::string_view instance,
+      const std::string_view reference) {
+      std::vector<std::pair<unsigned, std::string_view>> sequence;
+      for_each(node, instance, [&](const ptree& element) {
+        if (const auto ref = child(element, reference)) {
+          sequence.emplace_back(number(text(element, "SEQUENCE-NUMBER")).value_or(0), attribute(*ref, "ID-REF"));
+        }
+      });
+      std::stable_sort(sequence.begin(), sequence.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+      std::vector<std::string_view> result;
+      result.reserve(sequence.size());
+      for (const auto& [_, id] : sequence) {
+        result.push_back(id);
+      }
+      return result;
+    }
+
+    template <typename T>
+    void write(std::ostream& os, const T* data, const std::size_t count) {
+      os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+
+    template <typename T>
+    bool read(std::istream& is, T* data, const std::size_t count) {
+      return static_cast<bool>(is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+  }
+
+  MessageCatalog MessageCatalog::loadFibex(const std::filesystem::path& path) {
+    ptree document;
+    boost::property_tree::read_xml(path.string(), document);
+
+    // type info of a signal: by its coding unless DLT viewer knows the id
+    std::unordered_map<std::string_view, std::string_view> codings;
+    for_each(document, "CODING", [&codings](const ptree& coding) {
+      if (const auto coded = child(coding, "CODED-TYPE")) {
+        codings.emplace(attribute(coding, "ID"), attribute(*coded, "BASE-DATA-TYPE"));
+      }
+    });
+    std::unordered_map<std::string_view, uint32_t> signals;
+    for_each(document, "SIGNAL", [&signals, &codings](const ptree& signal) {
+      if (const auto ref = child(signal, "CODING-REF")) {
+        if (const auto coding = codings.find(attribute(*ref, "ID-REF")); coding != codings.end()) {
+          signals.emplace(attribute(signal, "ID"), base_type(coding->second));
+        }
+      }
+    });
+    const auto type_of = [&signals](const std::string_view id) -> uint32_t {
+      // ArgParser does not decode utf-8: such frames are left unknown whatever the coding says
+      if (id == "S_STRG_UTF8") {
+        return 0;
+      }
+      if (const auto type = signal_type(id)) {
+        return type;
+      }
+      const auto found = signals.find(id);
+      return found != signals.end() ? found->second : 0;
+    };
+
+    // a pdu is either static text or the signals (arguments)
+    struct pdu {
+      std::string_view text;
+      std::vector<std::string_view> signals;
+    };
+    std::unordered_map<std::string_view, pdu> pdus;
+    for_each(document, "PDU", [&pdus](const ptree& element) {
+      const auto description = text(element, "DESC");
+      pdus.emplace(attribute(element, "ID"), pdu{ description, references(element, "SIGNAL-INSTANCE", "SIGNAL-REF") });
+    });
+
+    MessageCatalog catalog;
+    for_each(document, "FRAME", [&](const ptree& frame) {
+      auto name = attribute(frame, "ID");
+      if (name.substr(0, FRAME_PREFIX.size()) == FRAME_PREFIX) {
+        name.remove_prefix(FRAME_PREFIX.size());
+      }
+      const auto id = number(name);
+      if (!id || catalog.layouts_.count(*id) != 0) {
+        return;
+      }
+
+      // the frame is compiled aside: it is dropped as a whole if anything is unsupported
+      std::vector<argument> arguments;
+      const auto text_size = catalog.text_.size();
+      bool supported = true;
+      for (const auto& pdu_id : references(frame, "PDU-INSTANCE", "PDU-REF")) {
+        const auto found = pdus.find(pdu_id);
+        if (found == pdus.end()) {
+          supported = false;
+          break;
+        }
+        const auto& [description, pdu_signals] = found->second;
+        if (pdu_signals.empty()) {
+          arguments.push_back({ 0, static_cast<uint32_t>(catalog.text_.size()), static_cast<uint32_t>(description.size()) });
+          catalog.text_ += description;
+          continue;
+        }
+        for (const auto& signal : pdu_signals) {
+          const auto type = type_of(signal);
+          if (type == 0) {
+            supported = false;
+            break;
+          }
+          arguments.push_back({ type, 0, 0 });
+        }
+      }
+
+      if (!supported) {
+        catalog.text_.resize(text_size);
+        return;
+      }
+      const auto first = static_cast<uint32_t>(catalog.arguments_.size());
+      catalog.arguments_.insert(catalog.arguments_.end(), arguments.begin(), arguments.end());
+      catalog.layouts_.emplace(*id, std::make_pair(first, static_cast<uint32_t>(arguments.size())));
+    });
+
+    return catalog;
+  }
+
+  bool MessageCatalog::format(const uint32_t id, const uint8_t* payload, const uint8_t* end, const bool isBigEndian,
+    std::string& output) const {
+    const auto found = layouts_.find(id);
+    if (found == layouts_.end()) {
+      return false;
+    }
+
+    // separated by spaces as the arguments of a verbose message are
+    const auto [first, count] = found->second;
+    const auto append = [this, first = first, count = count, &output](auto&& parser) {
+      for (auto i = first; i != first + count; ++i) {
+        if (i != first) {
+          output.push_back(' ');
+        }
+        const auto& arg = arguments_[i];
+        if (arg.type == 0) {
+          output.append(text_, arg.text_offset, arg.text_len);
+        }
+        else {
+          parser.parse(arg.type);
+        }
+      }
+    };
+    if (isBigEndian) {
+      append(ArgParser<true>(payload, end, output));
+    }
+    else {
+      append(ArgParser<false>(payload, end, output));
+    }
+    return true;
+  }
+
+  bool MessageCatalog::isWellFormed(const uint32_t id, const uint8_t* payload, const uint8_t* end,
+    const bool isBigEndian) const noexcept {
+    const auto found = layouts_.find(id);
+    if (found == layouts_.end()) {
+      return true;
+    }
+
+    const auto [first, count] = found->second;
+    for (auto i = first; i != first + count && payload != nullptr; ++i) {
+      const auto type = arguments_[i].type;
+      if (type != 0) {
+        payload = isBigEndian ? ArgParser<true>::skip(type, payload, end) : ArgParser<false>::skip(type, payload, end);
+      }
+    }
+    return payload != nullptr;
+  }
+
+  std::size_t MessageCatalog::size() const noexcept {
+    return layouts_.size();
+  }
+
+  void MessageCatalog::save(std::ostream& os) const {
+    const uint64_t sizes[] = { layouts_.size(), arguments_.size(), text_.size() };
+    write(os, sizes, std::size(sizes));
+    for (const auto& [id, layout] : layouts_) {
+      const uint32_t entry[] = { id, layout.first, layout.second };
+      write(os, entry, std::size(entry));
+    }
+    write(os, arguments_.data(), arguments_.size());
+    write(os, text_.data(), text_.size());
+  }
+
+  bool MessageCatalog::load(std::istream& is) {
+    uint64_t sizes[3]{};
+    if (!read(is, sizes, std::size(sizes))) {
+      return false;
+    }
+
+    layouts_.clear();
+    layouts_.reserve(sizes[0]);
+    for (uint64_t i = 0; i != sizes[0]; ++i) {
+      uint32_t entry[3]{};
+      if (!read(is, entry, std::size(entry)) || static_cast<uint64_t>(entry[1]) + entry[2] > sizes[1]) {
+        return false;
+      }
+      layouts_.emplace(entry[0], std::make_pair(entry[1], entry[2]));
+    }
+
+    arguments_.resize(sizes[1]);
+    text_.resize(sizes[2]);
+    if (!read(is, arguments_.data(), arguments_.size()) || !read(is, text_.data(), text_.size())) {
+      return false;
+    }
+    return std::all_of(arguments_.cbegin(), arguments_.cend(), [this](const argument& arg) {
+      return static_cast<uint64_t>(arg.text_offset) + arg.text_len <= text_.size();
+    });
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dlt {
+  // layouts of non-verbose messages by their id, compiled from a FIBEX file (the one DLT viewer's non-verbose
+  // plugin reads). a payload is formatted by the same kernels as a verbose one: every argument of the layout
+  // carries the type info a verbose message would have in its payload
+  class MessageCatalog final {
+  public:
+    MessageCatalog() = default;
+
+    // throws std::runtime_error if the file is not a readable FIBEX. frames with unsupported signals are skipped
+    // compiling a big catalog takes a while, see index::save/index::load_catalog for the cached binary form
+    [[nodiscard]] static MessageCatalog loadFibex(const std::filesystem::path& path);
+
+    // appends the message of the payload (arguments after the message id) to output
+    // returns false for an unknown id. throws except::parse_exception if the payload does not match the layout
+    bool format(uint32_t id, const uint8_t* payload, const uint8_t* end, bool isBigEndian, std::string& output) const;
+
+    // whether format accepts the payload, checked without formatting it. an unknown id is accepted
+    [[nodiscard]] bool isWellFormed(uint32_t id, const uint8_t* payload, const uint8_t* end, bool isBigEndian) const noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    void save(std::ostream& os) const;
+    // returns false if the dump is broken
+    [[nodiscard]] bool load(std::istream& is);
+
+  private:
+    // static text of the message or an argument read from the payload
+    struct argument {
+      // verbose type info (conformance::ArgType with tyle and coding), 0 for the static text
+      uint32_t type;
+      // text_[text_offset, text_offset + text_len)
+      uint32_t text_offset;
+      uint32_t text_len;
+    };
+
+    // message id to [first, first + count) of arguments_
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> layouts_;
+    std::vector<argument> arguments_;
+    std::string text_;
+  };
+}
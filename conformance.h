@@ -0,0 +1,313 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <array>
+#include <type_traits>
+
+#include "exceptions.h"
+
+/* compiler-specific struct packing */
+#ifndef PACK_1
+# ifdef _MSC_VER
+#  define PACK_1(decl)  __pragma(pack(push, 1)) decl __pragma(pack(pop))
+# else
+#  error please, implement compiler-specific pack
+# endif
+#endif
+
+namespace dlt {
+  /* compilance layer with the original DLT protocol */
+  namespace conformance {
+    constexpr size_t DLT_ID_SIZE = 4;
+    using ID4 = uint8_t[DLT_ID_SIZE];
+
+    /* every stored DLT message starts with this pattern */
+    constexpr std::string_view DLT_STORAGE_PATTERN{ "DLT\x1", 4 };
+
+    /* htyp flags */
+    enum class HtypMask : uint8_t {
+      /**< use extended header */
+      UEH = 0x01,
+      /**< MSB first */
+      MSBF = 0x02,
+      /**< with ECU ID */
+      WEID = 0x04,
+      /**< with session ID */
+      WSID = 0x08,
+      /**< with timestamp */
+      WTMS = 0x10,
+      /**< version number, 0x1 */
+      VERS = 0xe0
+    };
+
+    /* msin flags */
+    enum class MsinMask : uint8_t {
+      /**< verbose */
+      VERB = 0x01,
+      /**< message type */
+      MSTP = 0x0e,
+      /**< message type info */
+      MTIN = 0xf0
+    };
+
+    /* verbose mode of the message */
+    enum class Mode : int8_t {
+      Unknown = -2,
+      NonVerbose = 0,
+      Verbose
+    };
+
+    /* type of the DLT message */
+    enum class MsgType : int8_t {
+      TypeUnknown = -2,
+      TypeLog = 0,
+      TypeAppTrace,
+      TypeNwTrace,
+      TypeControl
+    };
+
+    /* subtype of the DLT message, if type is TypeLog */
+    enum class LogType : int8_t {
+      LogUnknown = -2,
+      LogDefault = -1,
+      LogOff = 0,
+      LogFatal,
+      LogError,
+      LogWarn,
+      LogInfo,
+      LogDebug,
+      LogVerbose
+    };
+
+    /* subtype of the DLT message, if type is TypeAppTrace */
+    enum class TraceType : int8_t {
+      TraceUnknown = -2,
+      TraceVariable = 1,
+      TraceFunctionIn,
+      TraceFunctionOut,
+      TraceState,
+      TraceVfb
+    };
+
+    /* subtype of the DLT message, if type is TypeNwTrace */
+    enum class NetworkTraceType : int8_t {
+      NetworkTraceUnknown = -2,
+      NetworkTraceIpc = 1,
+      NetworkTraceCan,
+      NetworkTraceFlexray,
+      NetworkTraceMost
+    };
+
+    /* subtype of the DLT message, if type is TypeControl */
+    enum class ControlType : int8_t {
+      ControlUnknown = -2,
+      ControlRequest = 1,
+      ControlResponse,
+      ControlTime
+    };
+
+    /* definitions of DLT services */
+    enum class CtrlServiceId : uint32_t {
+      /**< Service ID: Set log level */
+      SET_LOG_LEVEL = 1,
+      /**< Service ID: Set trace status */
+      SET_TRACE_STATUS,
+      /**< Service ID: Get log info */
+      GET_LOG_INFO,
+      /**< Service ID: Get dafault log level */
+      GET_DEFAULT_LOG_LEVEL,
+      /**< Service ID: Store configuration */
+      STORE_CONFIG,
+      /**< Service ID: Reset to factory defaults */
+      RESET_TO_FACTORY_DEFAULT,
+      /**< Service ID: Set communication interface status */
+      SET_COM_INTERFACE_STATUS,
+      /**< Service ID: Set communication interface maximum bandwidth */
+      SET_COM_INTERFACE_MAX_BANDWIDTH,
+      /**< Service ID: Set verbose mode */
+      SET_VERBOSE_MODE,
+      /**< Service ID: Set message filtering */
+      SET_MESSAGE_FILTERING,
+      /**< Service ID: Set timing packets */
+      SET_TIMING_PACKETS,
+      /**< Service ID: Get local time */
+      GET_LOCAL_TIME,
+      /**< Service ID: Use ECU id */
+      USE_ECU_ID,
+      /**< Service ID: Use session id */
+      USE_SESSION_ID,
+      /**< Service ID: Use timestamp */
+      USE_TIMESTAM,
+      /**< Service ID: Use extended header */
+      USE_EXTENDED_HEADER,
+      /**< Service ID: Set default log level */
+      SET_DEFAULT_LOG_LEVEL,
+      /**< Service ID: Set default trace status */
+      SET_DEFAULT_TRACE_STATUS,
+      /**< Service ID: Get software version */
+      GET_SOFTWARE_VERSION,
+      /**< Service ID: Message buffer overflow */
+      MESSAGE_BUFFER_OVERFLOW,
+      /**< Service ID: Message unregister context */
+      UNREGISTER_CONTEXT = 0xf01,
+      /**< Service ID: Message connection info */
+      CONNECTION_INFO = 0xf02,
+      /**< Service ID: Timezone */
+      TIMEZONE = 0xf03,
+      /**< Service ID: Timezone */
+      MARKER = 0xf04,
+      /**< Service ID: Message Injection (minimal ID) */
+      CALLSW_CINJECTION = 0xFFF
+    };
+
+    inline std::string getCtrlServiceIdName(CtrlServiceId id) {
+      constexpr std::array CtrlServiceIdStrings{
+        "", "set_log_level", "set_trace_status", "get_log_info", "get_default_log_level", "store_config",
+        "reset_to_factory_default",
+        "set_com_interface_status", "set_com_interface_max_bandwidth", "set_verbose_mode", "set_message_filtering",
+        "set_timing_packets",
+        "get_local_time", "use_ecu_id", "use_session_id", "use_timestamp", "use_extended_header",
+        "set_default_log_level", "set_default_trace_status",
+        "get_software_version", "message_buffer_overflow"
+      };
+
+      using underlying_t = std::underlying_type_t<decltype(id)>;
+
+      const auto index = static_cast<underlying_t>(id);
+
+      if (index < static_cast<underlying_t>(CtrlServiceId::SET_LOG_LEVEL) || index > static_cast<underlying_t>(
+        CtrlServiceId::MESSAGE_BUFFER_OVERFLOW)) {
+        return "service(" + std::to_string(index) + ")";
+      }
+
+      return CtrlServiceIdStrings[index];
+    }
+
+    /* definition of DLT ctrl return types*/
+    enum class CtrlReturnType : uint8_t {
+      OK,
+      NOT_SUPPORTED,
+      ERROR,
+      _3,
+      _4,
+      _5,
+      _6,
+      _7,
+      NO_MATCHING_CONTEXT_ID
+    };
+
+    constexpr auto getCtrlReturnTypeName(CtrlReturnType type) {
+      constexpr std::array CtrlReturnTypeStrings{
+        "ok", "not_supported", "error", "3", "4", "5", "6", "7", "no_matching_context_id"
+      };
+
+      const auto index = static_cast<std::underlying_type_t<decltype(type)>>(type);
+
+      if (index >= CtrlReturnTypeStrings.size()) {
+        throw except::parse_exception("invalid CtrlReturnType");
+      }
+
+      return CtrlReturnTypeStrings[index];
+    }
+
+    enum class ConnectionStatus : uint8_t {
+      /**< Client is disconnected */
+      DISCONNECTED = 1,
+      /**< Client is connected */
+      CONNECTED
+    };
+
+    constexpr auto getConnectionStatus(ConnectionStatus status) {
+      if (status == ConnectionStatus::DISCONNECTED) {
+        return "disconnected";
+      }
+      if (status == ConnectionStatus::CONNECTED) {
+        return "connected";
+      }
+      return "unknown";
+    }
+
+    constexpr bool extractHtyp(uint8_t htyp, HtypMask mask) {
+      return htyp & static_cast<uint8_t>(mask);
+    }
+
+    template <MsinMask mask>
+    constexpr uint8_t extractMsin(uint8_t msin) {
+      int shift{};
+      if constexpr (mask == MsinMask::VERB) {
+        shift = 0;
+      }
+      else if constexpr (mask == MsinMask::MSTP) {
+        shift = 1;
+      }
+      else if constexpr (mask == MsinMask::MTIN) {
+        shift = 4;
+      }
+      else {
+        throw "unknown MsinMask"; // static exception, no need to use std::exception
+      }
+
+      const auto byte = static_cast<uint8_t>(mask);
+      return (msin & byte) >> shift;
+    }
+
+    PACK_1(
+      /**
+       * The structure of the DLT file storage header. This header is used before each stored DLT message.
+       */
+      struct DltStorageHeader
+    {
+      /**< This pattern should be DLT0x01 */
+      ID4 pattern;
+      /**< seconds since 1.1.1970 */
+      uint32_t seconds;
+      /**< Microseconds */
+      uint32_t microseconds;
+      /**< The ECU id is added, if it is not already in the DLT message itself */
+      ID4 ecu;
+    };
+
+    /**
+     * The structure of the DLT standard header. This header is used in each DLT message.
+     */
+    struct DltStandardHeader
+    {
+      /**< This parameter contains several informations, see definitions below */
+      uint8_t htyp;
+      /**< The message counter is increased with each sent DLT message */
+      uint8_t mcnt;
+      /**< Length of the complete message, without storage header */
+      uint16_t len;
+    };
+
+    /**
+     * The structure of the DLT extra header parameters. Each parameter is sent only if enabled in htyp.
+     */
+    struct DltStandardHeaderExtra
+    {
+      /**< ECU id */
+      ID4 ecu;
+      /**< Session number */
+      uint32_t seid;
+      /**< Timestamp since system start in 0.1 milliseconds */
+      uint32_t tmsp;
+    };
+
+    /**
+     * The structure of the DLT extended header. This header is only sent if enabled in htyp parameter.
+     */
+    struct DltExtendedHeader
+    {
+      /**< messsage info */
+      uint8_t msin;
+      /**< number of arguments */
+      uint8_t noar;
+      /**< application id */
+      ID4 apid;
+      /**< context id */
+      ID4 ctid;
+    }
+    );
+  };
+}
@@ -0,0 +1,173 @@
+#include <fstream>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined DLT_WITH_GZIP || defined DLT_WITH_XZ
+# include <boost/iostreams/filtering_stream.hpp>
+# include <boost/iostreams/copy.hpp>
+# include <boost/iostreams/device/back_inserter.hpp>
+#endif
+#ifdef DLT_WITH_GZIP
+# include <boost/iostreams/filter/gzip.hpp>
+#endif
+#ifdef DLT_WITH_XZ
+# include <boost/iostreams/filter/lzma.hpp>
+#endif
+#ifdef DLT_WITH_ZSTD
+# include <zstd.h>
+#endif
+
+#include "decompress.h"
+#include "thread_pool.h"
+#include "thread_supervisor.h"
+
+namespace dlt::fs {
+  namespace {
+    constexpr std::array<uint8_t, 2> GZIP_MAGIC{ 0x1f, 0x8b };
+    constexpr std::array<uint8_t, 6> XZ_MAGIC{ 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+    constexpr std::array<uint8_t, 4> ZSTD_MAGIC{ 0x28, 0xb5, 0x2f, 0xfd };
+
+    template <std::size_t N>
+    bool starts_with(const std::array<char, 6>& header, const std::size_t len, const std::array<uint8_t, N>& magic) {
+      return len >= N && ::memcmp(header.data(), magic.data(), N) == 0;
+    }
+
+#if defined DLT_WITH_GZIP || defined DLT_WITH_XZ || defined DLT_WITH_ZSTD
+    // the buffer is owned by the vector, nothing is copied
+    decompressed adopt(std::vector<char>&& buffer) {
+      auto holder = std::make_shared<std::vector<char>>(std::move(buffer));
+      const auto len = holder->size();
+      return { std::shared_ptr<char[]>(holder, holder->data()), len };
+    }
+#endif
+
+#if defined DLT_WITH_GZIP || defined DLT_WITH_XZ
+    // multi-member gzip is handled by the filter, but serially: member boundaries are unknown until inflated
+    template <typename Filter>
+    decompressed decompress_filter(const std::filesystem::path& path, Filter&& filter) {
+      std::ifstream is(path, std::ios::binary);
+      boost::iostreams::filtering_istreambuf in;
+      in.push(std::forward<Filter>(filter));
+      in.push(is);
+
+      std::vector<char> buffer;
+      boost::iostreams::copy(in, boost::iostreams::back_inserter(buffer));
+      return adopt(std::move(buffer));
+    }
+#endif
+
+#ifdef DLT_WITH_ZSTD
+    // frames without the content size in their header are streamed in a row
+    decompressed decompress_zstd_stream(const std::vector<char>& input) {
+      std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream(ZSTD_createDStream(), &ZSTD_freeDStream);
+      std::vector<char> buffer;
+      ZSTD_inBuffer in{ input.data(), input.size(), 0 };
+      while (true) {
+        const auto offset = buffer.size();
+        buffer.resize(offset + ZSTD_DStreamOutSize());
+        ZSTD_outBuffer out{ buffer.data() + offset, ZSTD_DStreamOutSize(), 0 };
+        if (ZSTD_isError(ZSTD_decompressStream(stream.get(), &out, &in))) {
+          throw std::runtime_error("broken zstd stream");
+        }
+        buffer.resize(offset + out.pos);
+        // full output buffer means the decoder may still have something to flush
+        if (in.pos == in.size && out.pos < out.size) {
+          break;
+        }
+      }
+      return adopt(std::move(buffer));
+    }
+
+    decompressed decompress_zstd(const std::filesystem::path& path) {
+      std::ifstream is(path, std::ios::binary);
+      const std::vector<char> input((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+      // frames are independent, hence each one is decompressed straight into its place of the output
+      struct frame {
+        std::size_t src_offset;
+        std::size_t src_size;
+        std::size_t dst_offset;
+        std::size_t dst_size;
+      };
+      std::vector<frame> frames;
+      std::size_t len = 0;
+      for (std::size_t offset = 0; offset < input.size();) {
+        const auto src_size = ZSTD_findFrameCompressedSize(input.data() + offset, input.size() - offset);
+        if (ZSTD_isError(src_size)) {
+          throw std::runtime_error("broken zstd frame");
+        }
+        const auto dst_size = ZSTD_getFrameContentSize(input.data() + offset, src_size);
+        if (dst_size == ZSTD_CONTENTSIZE_UNKNOWN || dst_size == ZSTD_CONTENTSIZE_ERROR) {
+          return decompress_zstd_stream(input);
+        }
+        frames.push_back({ offset, src_size, len, static_cast<std::size_t>(dst_size) });
+        len += static_cast<std::size_t>(dst_size);
+        offset += src_size;
+      }
+
+      std::shared_ptr<char[]> data(new char[len]);
+      std::atomic<bool> failed{ false };
+      thread_pool::instance().parallel_for(frames.size(), [&](const std::size_t i) {
+        const auto& frame = frames[i];
+        const auto written = ZSTD_decompress(data.get() + frame.dst_offset, frame.dst_size,
+          input.data() + frame.src_offset, frame.src_size);
+        if (ZSTD_isError(written) || written != frame.dst_size) {
+          failed = true;
+        }
+      }, supervisor::cores_num);
+
+      if (failed) {
+        throw std::runtime_error("broken zstd frame");
+      }
+      return { std::move(data), len };
+    }
+#endif
+  }
+
+  compression detect_compression(const std::filesystem::path& path) {
+    std::array<char, 6> header{};
+    std::ifstream is(path, std::ios::binary);
+    is.read(header.data(), header.size());
+    const auto len = static_cast<std::size_t>(is.gcount());
+
+    if (starts_with(header, len, GZIP_MAGIC)) {
+      return compression::gzip;
+    }
+    if (starts_with(header, len, XZ_MAGIC)) {
+      return compression::xz;
+    }
+    if (starts_with(header, len, ZSTD_MAGIC)) {
+      return compression::zstd;
+    }
+    return compression::none;
+  }
+
+  decompressed decompress([[maybe_unused]] const std::filesystem::path& path, const compression type) {
+    switch (type) {
+    case compression::gzip:
+#ifdef DLT_WITH_GZIP
+      return decompress_filter(path, boost::iostreams::gzip_decompressor{});
+#else
+      throw std::runtime_error("gzip support is not compiled in (DLT_WITH_GZIP)");
+#endif
+    case compression::xz:
+#ifdef DLT_WITH_XZ
+      return decompress_filter(path, boost::iostreams::lzma_decompressor{});
+#else
+      throw std::runtime_error("xz support is not compiled in (DLT_WITH_XZ)");
+#endif
+    case compression::zstd:
+#ifdef DLT_WITH_ZSTD
+      return decompress_zstd(path);
+#else
+      throw std::runtime_error("zstd support is not compiled in (DLT_WITH_ZSTD)");
+#endif
+    case compression::none:
+      break;
+    }
+    throw std::runtime_error("file is not compressed");
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include <filesystem>
+
+// in-process decompression of archived traces, so they can be parsed without unpacking them to disk first
+// every codec is optional and enabled by its build macro: DLT_WITH_GZIP and DLT_WITH_XZ (boost::iostreams
+// filters built with zlib/liblzma), DLT_WITH_ZSTD (libzstd). see codecs.props for turning them on in the projects
+namespace dlt::fs {
+  enum class compression {
+    none,
+    gzip,
+    xz,
+    zstd
+  };
+
+  // by the magic number of the file, not by its extension
+  [[nodiscard]]
+  compression detect_compression(const std::filesystem::path& path);
+
+  struct decompressed {
+    std::shared_ptr<char[]> data;
+    std::size_t len;
+  };
+
+  // the whole decompressed content. independent zstd frames are decompressed in parallel
+  // throws std::runtime_error if the data is broken or the codec is not compiled in
+  [[nodiscard]]
+  decompressed decompress(const std::filesystem::path& path, compression type);
+}
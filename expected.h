@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <utility>
+#include <type_traits>
+
+namespace dlt {
+  // non-throwing counterparts of except:: classes used on the hot path
+  enum class errc : uint8_t {
+    ok,
+    // nothing left to read or the data ended in the middle of a record
+    eof,
+    // the record did not match parse_options::filter, nothing was stored
+    filtered
+  };
+
+  // minimal std::expected-like holder (no std::expected on our toolset yet)
+  // value is only meaningful if there is no error
+  template <typename T>
+  class expected final {
+  public:
+    constexpr expected(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+      : value_(std::move(value)), error_(errc::ok) {
+    }
+
+    constexpr expected(const errc error) noexcept : value_{}, error_(error) {
+      assert(error != errc::ok);
+    }
+
+    [[nodiscard]]
+    constexpr bool has_value() const noexcept {
+      return error_ == errc::ok;
+    }
+
+    [[nodiscard]]
+    constexpr explicit operator bool() const noexcept {
+      return has_value();
+    }
+
+    [[nodiscard]]
+    constexpr const T& value() const noexcept {
+      assert(has_value());
+      return value_;
+    }
+
+    [[nodiscard]]
+    constexpr const T& operator*() const noexcept {
+      return value();
+    }
+
+    [[nodiscard]]
+    constexpr errc error() const noexcept {
+      return error_;
+    }
+
+  private:
+    T value_;
+    errc error_;
+  };
+}
@@ -1,33 +1,88 @@
 #include <fstream>
 #include <filesystem>
 #include <exception>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
 #include "filereader.h"
+#include "decompress.h"
 #include "exceptions.h"
+#include "search.h"
 
 namespace dlt::fs {
-  std::vector<std::unique_ptr<reader>> reader::split(const uint8_t num) {
-    if (len_ == 0) {
-      // split of uninitialized reader? likely file is empty
-      throw except::eof{};
+  namespace {
+    // ask the os to read [data, data + len) of a mapping in ahead of the page faults. best effort
+    void prefetch(const char* const data, const std::size_t len) noexcept {
+      if (len == 0) {
+        return;
+      }
+#ifdef _WIN32
+      WIN32_MEMORY_RANGE_ENTRY range{ const_cast<char*>(data), len };
+      static_cast<void>(::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0));
+#else
+      static const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+      const auto begin = reinterpret_cast<std::uintptr_t>(data) & ~(page_size - 1);
+      const auto end = reinterpret_cast<std::uintptr_t>(data) + len;
+      static_cast<void>(::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED));
+#endif
     }
+  }
 
+  std::vector<std::unique_ptr<reader>> reader::split(const std::size_t num) {
     std::vector<std::unique_ptr<reader>> readers;
+    readers.reserve(num);
     for (size_t i = 0; i != num; ++i) {
-      const auto reader_begin = len_ / num * i;
-      const auto reader_end = len_ / num * (i + 1) - 1;
-
-      readers.emplace_back(clone());
-      auto& back = readers.back();
-      back->pos_ = reader_begin;
-      back->chunk_len_ = reader_end;
+      readers.emplace_back(chunk(i, num));
     }
 
     return readers;
   }
 
+  std::unique_ptr<reader> reader::chunk(const std::size_t index, const std::size_t num) const {
+    if (len_ == 0) {
+      // split of uninitialized reader? likely file is empty
+      throw except::eof{};
+    }
+    assert(num > 0 && num <= len_ && index < num);
+
+    const auto reader_begin = len_ / num * index;
+    const auto reader_end = len_ / num * (index + 1) - 1;
+
+    auto&& result = clone();
+    result->io_stats_ = {};
+    result->pos_ = reader_begin;
+    // the last chunk takes the remainder of the division
+    result->chunk_len_ = index + 1 == num ? std::numeric_limits<decltype(chunk_len_)>::max() : reader_end;
+    return std::move(result);
+  }
+
+  std::unique_ptr<reader> reader::fork(const std::size_t pos) const {
+    assert(pos <= len_);
+    auto&& forked = clone();
+    forked->pos_ = pos;
+    forked->overrun_ = 0;
+    forked->current_offset_ = 0;
+    forked->first_valid_offset_ = 0;
+    forked->io_stats_ = {};
+    return std::move(forked);
+  }
+
   std::size_t reader::get_overrun() const {
     return overrun_;
   }
@@ -36,63 +91,225 @@ namespace dlt::fs {
     return first_valid_offset_;
   }
 
+  const char* reader::read(const std::size_t bytes_to_read) {
+    const auto entry = try_read(bytes_to_read);
+    // this is not ok. throw eof but with parse_exception ontop
+    if (!entry) {
+      try {
+        throw except::eof();
+      }
+      catch (...) {
+        std::throw_with_nested(except::parse_exception("file ended with incomplete record"));
+      }
+    }
+    return *entry;
+  }
+
+  expected<std::size_t> reader::advance(const std::size_t bytes_to_read) noexcept {
+    const auto new_pos = pos_ + bytes_to_read;
+
+    if (new_pos > len_) {
+      overrun_ = OVERRUN_EOF;
+      return errc::eof;
+    }
+
+    if (new_pos > chunk_len_) {
+      // store offset of overrun to keep it in mind while validating next chunk
+      overrun_ = new_pos;
+    }
+
+    const auto entry = pos_;
+    pos_ = new_pos;
+    return entry;
+  }
+
+  std::size_t reader::get_len() const noexcept {
+    return len_;
+  }
+
+  bool reader::is_eof() const noexcept {
+    return get_pos() >= len_;
+  }
+
+  bool reader::resync(const std::string_view pattern, const std::size_t pos) {
+    const auto found = find(pattern, pos);
+    DLT_STATS(io_stats_.resync_bytes += std::min(found, len_) - std::min(pos, len_));
+    if (found >= len_) {
+      // the same state as the byte-by-byte scan would reach by running into the end of file
+      pos_ = len_;
+      overrun_ = OVERRUN_EOF;
+      return false;
+    }
+    // chunk overrun (if any) is detected by the reads of the record found
+    pos_ = found;
+    return true;
+  }
+
+  void reader::hold(const std::size_t pos) noexcept {
+    assert(pos <= len_);
+    pos_ = pos;
+    overrun_ = 0;
+  }
+
   void reader::notify_success(const std::size_t offset) {
     if (first_valid_offset_ == 0) {
       first_valid_offset_ = offset;
     }
-    if (pos_ == len_) {
-      throw except::eof();
-    }
   }
 
+  const io_stats& reader::get_io_stats() const noexcept {
+    return io_stats_;
+  }
+
+  // loads the file into the buffer in blocks by several threads using positional reads
+  // readers wait only for the blocks they need, so parsing of the first chunks overlaps with loading of the rest
+  class precache_loader final {
+  public:
+    static constexpr std::size_t BLOCK_SIZE = 4 * 1024 * 1024;
+    static constexpr unsigned THREADS_NUM = 4;
+
+    precache_loader(const std::filesystem::path& path, char* const buffer, const std::size_t len)
+      : buffer_(buffer), len_(len), blocks_num_((len + BLOCK_SIZE - 1) / BLOCK_SIZE),
+      ready_(new std::atomic<bool>[blocks_num_]) {
+      for (std::size_t i = 0; i != blocks_num_; ++i) {
+        ready_[i] = false;
+      }
+      // every thread has its own handle, hence positional reads do not interfere
+      const auto threads_num = static_cast<unsigned>(std::min<std::size_t>(THREADS_NUM, blocks_num_));
+      threads_.reserve(threads_num);
+      for (unsigned i = 0; i != threads_num; ++i) {
+        threads_.emplace_back(&precache_loader::load, this, path);
+      }
+    }
+
+    precache_loader(const precache_loader&) = delete;
+    precache_loader& operator=(const precache_loader&) = delete;
+
+    ~precache_loader() {
+      // nobody is going to read the rest
+      stop_ = true;
+      for (auto& thread : threads_) {
+        thread.join();
+      }
+    }
+
+    // waits until [begin, end) is loaded. false on i/o error
+    [[nodiscard]]
+    bool wait(const std::size_t begin, const std::size_t end) noexcept {
+      if (begin == end) {
+        return true;
+      }
+      for (auto block = begin / BLOCK_SIZE; block <= (end - 1) / BLOCK_SIZE; ++block) {
+        if (ready_[block].load(std::memory_order_acquire)) {
+          continue;
+        }
+        std::unique_lock lock(mutex_);
+        loaded_.wait(lock, [this, block]() { return ready_[block].load(std::memory_order_acquire) || failed_; });
+        if (!ready_[block]) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  private:
+    void load(const std::filesystem::path& path) {
+      std::ifstream is(path, std::ios::binary);
+      // blocks are taken in file order, the same order chunks are parsed in
+      for (auto block = next_++; block < blocks_num_ && !stop_ && !failed_; block = next_++) {
+        const auto offset = block * BLOCK_SIZE;
+        const auto size = std::min(BLOCK_SIZE, len_ - offset);
+        const bool ok = is.seekg(static_cast<std::streamoff>(offset)) &&
+          is.read(buffer_ + offset, static_cast<std::streamsize>(size));
+
+        {
+          std::lock_guard lock(mutex_);
+          if (ok) {
+            ready_[block].store(true, std::memory_order_release);
+          }
+          else {
+            failed_ = true;
+          }
+        }
+        loaded_.notify_all();
+      }
+    }
+
+    char* const buffer_;
+    const std::size_t len_;
+    const std::size_t blocks_num_;
+    std::unique_ptr<std::atomic<bool>[]> ready_;
+    std::atomic<std::size_t> next_{ 0 };
+    std::atomic<bool> stop_{ false };
+    std::atomic<bool> failed_{ false };
+
+    std::mutex mutex_;
+    std::condition_variable loaded_;
+    std::vector<std::thread> threads_;
+  };
+
   class file_precache final : public reader {
   private:
     file_precache(const file_precache&) = default;
 
     std::shared_ptr<char[]> buffer_;
+    // shared by the clones. nullptr once the file is loaded synchronously
+    std::shared_ptr<precache_loader> loader_;
+    mutable std::size_t loaded_begin_{ 0 };
+    mutable std::size_t loaded_end_{ 0 };
 
     [[nodiscard]]
-    std::unique_ptr<reader> clone() override {
+    std::unique_ptr<reader> clone() const override {
       return std::unique_ptr<reader>(new file_precache(*this));
     }
 
+    // blocks are never unloaded, so the last loaded block waited for is remembered by the reader
+    [[nodiscard]]
+    bool wait(const std::size_t begin, const std::size_t end) const noexcept {
+      if (loader_ == nullptr || begin == end || (begin >= loaded_begin_ && end <= loaded_end_)) {
+        return true;
+      }
+      DLT_STATS(const scoped_timer timer(io_stats_.wait));
+      if (!loader_->wait(begin, end)) {
+        return false;
+      }
+      loaded_begin_ = (end - 1) / precache_loader::BLOCK_SIZE * precache_loader::BLOCK_SIZE;
+      loaded_end_ = std::min(len_, loaded_begin_ + precache_loader::BLOCK_SIZE);
+      return true;
+    }
+
   public:
     file_precache(file_precache&&) = delete;
 
-    explicit file_precache(const std::filesystem::path& path) {
-      std::ifstream is(path, std::ios::binary);
-
-      is.seekg(0, std::ios::end);
-      len_ = is.tellg();
-      is.seekg(0, std::ios::beg);
+    // the content is already in memory (e.g. decompressed)
+    file_precache(std::shared_ptr<char[]> buffer, const std::size_t len) : buffer_(std::move(buffer)) {
+      len_ = len;
+    }
 
+    explicit file_precache(const std::filesystem::path& path) {
+      len_ = std::filesystem::file_size(path);
       buffer_.reset(new char[len_]);
-      is.read(buffer_.get(), len_);
+
+      // small files are not worth the threads
+      if (len_ <= precache_loader::BLOCK_SIZE) {
+        std::ifstream is(path, std::ios::binary);
+        is.read(buffer_.get(), len_);
+        return;
+      }
+      loader_ = std::make_shared<precache_loader>(path, buffer_.get(), len_);
     }
 
+    // i/o errors look like the end of file: the record being read is reported as incomplete
     [[nodiscard]]
-    const char* read(const std::size_t bytes_to_read) override {
-      const auto new_pos = pos_ + bytes_to_read;
-
-      // this is not ok. throw eof but with parse_exception ontop
-      if (new_pos > len_) {
-        overrun_ = OVERRUN_EOF;
-        try {
-          throw except::eof();
-        }
-        catch(...) {
-          std::throw_with_nested(except::parse_exception("file ended with incomplete record"));
-        }
+    expected<const char*> try_read(const std::size_t bytes_to_read) noexcept override {
+      const auto pos = advance(bytes_to_read);
+      if (!pos) {
+        return pos.error();
       }
-
-      if (new_pos > chunk_len_) {
-        // store offset of overrun to keep it in mind while validating next chunk
-        overrun_ = new_pos;
+      if (!wait(*pos, *pos + bytes_to_read)) {
+        return errc::eof;
       }
-
-      auto&& entry = buffer_.get() + pos_;
-      pos_ = new_pos;
-      return entry;
+      return buffer_.get() + *pos;
     }
 
     void set_pos(const std::size_t pos) override {
@@ -104,19 +321,66 @@ namespace dlt::fs {
     size_t get_pos() const noexcept override {
       return pos_;
     }
+
+    [[nodiscard]]
+    std::shared_ptr<const void> get_storage() const noexcept override {
+      return buffer_;
+    }
+
+  private:
+    [[nodiscard]]
+    std::size_t find(const std::string_view pattern, const std::size_t pos) const override {
+      if (loader_ == nullptr) {
+        return search::find(buffer_.get(), len_, pattern, pos);
+      }
+
+      // search block by block, so only the blocks before the occurence have to be loaded
+      const auto tail = pattern.size() - 1;
+      for (auto begin = pos / precache_loader::BLOCK_SIZE * precache_loader::BLOCK_SIZE; begin < len_;
+        begin += precache_loader::BLOCK_SIZE) {
+        const auto end = std::min(len_, begin + precache_loader::BLOCK_SIZE + tail);
+        if (!wait(std::max(pos, begin), end)) {
+          break;
+        }
+        if (const auto found = search::find(buffer_.get(), end, pattern, std::max(pos, begin)); found < end) {
+          return found;
+        }
+      }
+      return len_;
+    }
   };
 
   class file_map final : public reader {
   private:
     file_map(const file_map&) = default;
 
+    // every reader (i.e. every chunk) keeps this much of the mapping prefetched ahead of its position
+    static constexpr std::size_t PREFETCH_WINDOW = 8 * 1024 * 1024;
+
     std::shared_ptr<boost::iostreams::mapped_file> mapped_file_;
+    // [prefetched_begin_, prefetched_end_) is already requested from the os
+    std::size_t prefetched_begin_{ 0 };
+    std::size_t prefetched_end_{ 0 };
 
     [[nodiscard]]
-    std::unique_ptr<reader> clone() override {
+    std::unique_ptr<reader> clone() const override {
       return std::unique_ptr<reader>(new file_map(*this));
     }
 
+    // sequential reads extend the window once half of it is consumed, jumps (e.g. split or set_pos) restart it
+    void read_ahead(const std::size_t pos) noexcept {
+      if (pos >= prefetched_begin_ && pos + PREFETCH_WINDOW / 2 <= prefetched_end_) {
+        return;
+      }
+      const auto begin = pos >= prefetched_begin_ && pos <= prefetched_end_ ? prefetched_end_ : pos;
+      const auto end = std::min(len_, pos + PREFETCH_WINDOW);
+      if (begin < end) {
+        prefetch(mapped_file_->const_data() + begin, end - begin);
+      }
+      prefetched_begin_ = pos;
+      prefetched_end_ = end;
+    }
+
   public:
     file_map(file_precache&&) = delete;
 
@@ -128,14 +392,212 @@ namespace dlt::fs {
     }
 
     [[nodiscard]]
-    const char* read(const std::size_t bytes_to_read) override {
-      if (pos_ + bytes_to_read > len_) {
-        throw except::eof{};
+    expected<const char*> try_read(const std::size_t bytes_to_read) noexcept override {
+      const auto pos = advance(bytes_to_read);
+      if (!pos) {
+        return pos.error();
+      }
+      read_ahead(*pos);
+      return mapped_file_->const_data() + *pos;
+    }
+
+    void set_pos(const std::size_t pos) override {
+      assert(pos < len_);
+      pos_ = pos;
+    }
+
+    [[nodiscard]]
+    size_t get_pos() const noexcept override {
+      return pos_;
+    }
+
+    [[nodiscard]]
+    std::shared_ptr<const void> get_storage() const noexcept override {
+      return mapped_file_;
+    }
+
+  private:
+    [[nodiscard]]
+    std::size_t find(const std::string_view pattern, const std::size_t pos) const override {
+      return search::find(mapped_file_->const_data(), len_, pattern, pos);
+    }
+  };
+
+  // reads the file sequentially through a ring of blocks which are filled ahead by a separate thread
+  // memory is bounded by the ring, hence pointers returned by read() are valid until the next read only
+  // records which straddle two blocks are stitched into a separate buffer
+  class file_stream final : public reader {
+  private:
+    static constexpr std::size_t BLOCK_SIZE = 1024 * 1024;
+    static constexpr std::size_t BLOCKS_NUM = 4;
+
+    // window of BLOCKS_NUM consecutive blocks starting with the one being consumed
+    class ring final {
+    public:
+      ring(const std::filesystem::path& path, const std::size_t len, const std::size_t first_block)
+        : is_(path, std::ios::binary), len_(len), consumed_(first_block), loaded_(first_block) {
+        for (auto& slot : slots_) {
+          slot.reset(new char[BLOCK_SIZE]);
+        }
+        thread_ = std::thread(&ring::prefetch, this);
+      }
+
+      ring(const ring&) = delete;
+      ring& operator=(const ring&) = delete;
+
+      ~ring() {
+        {
+          std::lock_guard lock(mutex_);
+          stop_ = true;
+        }
+        ready_.notify_all();
+        thread_.join();
+      }
+
+      [[nodiscard]]
+      bool contains(const std::size_t block) const noexcept {
+        return block >= consumed_ && block < consumed_ + BLOCKS_NUM;
+      }
+
+      // waits until the block is loaded. the slots of the previous blocks are given to read-ahead from now on
+      // returns nullptr on i/o error
+      [[nodiscard]]
+      const char* acquire(const std::size_t block) {
+        assert(contains(block));
+        std::unique_lock lock(mutex_);
+        consumed_ = block;
+        ready_.notify_all();
+        ready_.wait(lock, [this, block]() { return loaded_ > block || failed_; });
+        return loaded_ > block ? slots_[block % BLOCKS_NUM].get() : nullptr;
+      }
+
+      // the same as acquire but the blocks before it keep their slots, so the acquired block stays valid
+      [[nodiscard]]
+      const char* peek(const std::size_t block) {
+        assert(contains(block));
+        std::unique_lock lock(mutex_);
+        ready_.wait(lock, [this, block]() { return loaded_ > block || failed_; });
+        return loaded_ > block ? slots_[block % BLOCKS_NUM].get() : nullptr;
+      }
+
+    private:
+      void prefetch() {
+        is_.seekg(static_cast<std::streamoff>(loaded_ * BLOCK_SIZE));
+        while (true) {
+          std::unique_lock lock(mutex_);
+          ready_.wait(lock, [this]() {
+            return stop_ || (loaded_ < consumed_ + BLOCKS_NUM && loaded_ * BLOCK_SIZE < len_);
+          });
+          if (stop_) {
+            return;
+          }
+          // the slot is neither in use nor awaited by the consumer
+          const auto block = loaded_;
+          lock.unlock();
+
+          const auto size = std::min(BLOCK_SIZE, len_ - block * BLOCK_SIZE);
+          const bool ok = static_cast<bool>(is_.read(slots_[block % BLOCKS_NUM].get(), static_cast<std::streamsize>(size)));
+
+          lock.lock();
+          if (!ok) {
+            failed_ = true;
+            ready_.notify_all();
+            return;
+          }
+          ++loaded_;
+          ready_.notify_all();
+        }
+      }
+
+      std::ifstream is_;
+      const std::size_t len_;
+      std::unique_ptr<char[]> slots_[BLOCKS_NUM];
+
+      std::mutex mutex_;
+      std::condition_variable ready_;
+      std::size_t consumed_;
+      std::size_t loaded_;
+      bool failed_{ false };
+      bool stop_{ false };
+      std::thread thread_;
+    };
+
+    std::filesystem::path path_;
+    // created by the first read, restarted by the reads outside of its window
+    mutable std::unique_ptr<ring> ring_;
+    static constexpr std::size_t NO_BLOCK = std::numeric_limits<std::size_t>::max();
+    mutable std::size_t current_{ NO_BLOCK };
+    mutable const char* current_data_{ nullptr };
+    std::vector<char> stitch_;
+
+    file_stream(const file_stream& other) : reader(other), path_(other.path_) {
+    }
+
+    [[nodiscard]]
+    std::unique_ptr<reader> clone() const override {
+      return std::unique_ptr<reader>(new file_stream(*this));
+    }
+
+    [[nodiscard]]
+    const char* block(const std::size_t index) const {
+      // most of the reads hit the same block, the ring is not even locked then
+      if (index == current_ && ring_ != nullptr) {
+        return current_data_;
+      }
+      if (ring_ == nullptr || !ring_->contains(index)) {
+        ring_.reset();
+        ring_ = std::make_unique<ring>(path_, len_, index);
+      }
+      {
+        DLT_STATS(const scoped_timer timer(io_stats_.wait));
+        current_data_ = ring_->acquire(index);
+      }
+      current_ = current_data_ != nullptr ? index : NO_BLOCK;
+      return current_data_;
+    }
+
+  public:
+    file_stream(file_stream&&) = delete;
+
+    explicit file_stream(const std::filesystem::path& path) : path_(path) {
+      len_ = std::filesystem::file_size(path);
+    }
+
+    // i/o errors look like the end of file: the record being read is reported as incomplete
+    [[nodiscard]]
+    expected<const char*> try_read(const std::size_t bytes_to_read) noexcept override {
+      const auto pos = advance(bytes_to_read);
+      if (!pos) {
+        return pos.error();
       }
 
-      auto&& entry = mapped_file_->const_begin() + pos_;
-      pos_ += bytes_to_read;
-      return entry;
+      try {
+        const auto offset = *pos % BLOCK_SIZE;
+        if (offset + bytes_to_read <= BLOCK_SIZE) {
+          const auto data = block(*pos / BLOCK_SIZE);
+          if (data == nullptr) {
+            return errc::eof;
+          }
+          return data + offset;
+        }
+
+        stitch_.resize(bytes_to_read);
+        for (std::size_t copied = 0; copied != bytes_to_read;) {
+          const auto from = *pos + copied;
+          const auto data = block(from / BLOCK_SIZE);
+          if (data == nullptr) {
+            return errc::eof;
+          }
+          const auto count = std::min(bytes_to_read - copied, BLOCK_SIZE - from % BLOCK_SIZE);
+          ::memcpy(stitch_.data() + copied, data + from % BLOCK_SIZE, count);
+          copied += count;
+        }
+        return stitch_.data();
+      }
+      catch (...) {
+        // thread or buffers could not be created
+        return errc::eof;
+      }
     }
 
     void set_pos(const std::size_t pos) override {
@@ -147,14 +609,74 @@ namespace dlt::fs {
     size_t get_pos() const noexcept override {
       return pos_;
     }
+
+    // buffers are reused
+    [[nodiscard]]
+    std::shared_ptr<const void> get_storage() const noexcept override {
+      return nullptr;
+    }
+
+    void release() noexcept override {
+      ring_.reset();
+      current_ = NO_BLOCK;
+      stitch_ = {};
+    }
+
+  private:
+    [[nodiscard]]
+    std::size_t find(const std::string_view pattern, const std::size_t pos) const override {
+      const auto tail = pattern.size() - 1;
+      for (auto index = pos / BLOCK_SIZE; index * BLOCK_SIZE < len_; ++index) {
+        const auto begin = index * BLOCK_SIZE;
+        const auto size = std::min(BLOCK_SIZE, len_ - begin);
+        const auto from = std::max(pos, begin) - begin;
+
+        const auto data = block(index);
+        if (data == nullptr) {
+          break;
+        }
+        if (const auto found = search::find(data, size, pattern, from); found < size) {
+          return begin + found;
+        }
+
+        // occurence which straddles the end of the block
+        if (tail == 0 || begin + size == len_) {
+          continue;
+        }
+        const auto window_begin = std::max(from, size - std::min(size, tail));
+        std::string window(data + window_begin, data + size);
+        // the match would begin in this block: reading the next one must not move the ring past it
+        const char* next;
+        {
+          DLT_STATS(const scoped_timer timer(io_stats_.wait));
+          next = ring_->peek(index + 1);
+        }
+        if (next == nullptr) {
+          break;
+        }
+        window.append(next, std::min(tail, len_ - begin - size));
+        if (const auto found = search::find(window.data(), window.size(), pattern, 0); found < window.size()) {
+          return begin + window_begin + found;
+        }
+      }
+      return len_;
+    }
   };
 
   std::unique_ptr<reader> reader::factory(const reader_type type, const std::filesystem::path& path) {
+    // compressed files can only be parsed from memory, whatever reader is requested
+    if (const auto compression = detect_compression(path); compression != compression::none) {
+      auto&& [data, len] = decompress(path, compression);
+      return std::make_unique<file_precache>(std::move(data), len);
+    }
+
     switch (type) {
     case reader_type::file_precache:
       return std::make_unique<file_precache>(path);
     case reader_type::file_map:
       return std::make_unique<file_map>(path);
+    case reader_type::file_stream:
+      return std::make_unique<file_stream>(path);
     }
     throw std::runtime_error("unknown reader_type");
   }
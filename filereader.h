@@ -1,11 +1,18 @@
 #pragma once
 #include <memory>
 #include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "expected.h"
+#include "stats.h"
 
 namespace dlt::fs {
   enum class reader_type {
     file_precache,
-    file_map
+    file_map,
+    // bounded read-ahead buffers instead of the whole file in memory. read pointers are not stable
+    file_stream
   };
 
   class reader {
@@ -15,28 +22,76 @@ namespace dlt::fs {
 
     virtual ~reader() = default;
 
+    // returns pointer to the next bytes_to_read bytes or errc::eof if there are not enough of them
+    [[nodiscard]]
+    virtual expected<const char*> try_read(std::size_t bytes_to_read) noexcept = 0;
+
+    // throwing version of try_read. running out of data in the middle of a record is a parse error with nested eof
     [[nodiscard]]
-    virtual const char* read(std::size_t bytes_to_read) = 0;
+    const char* read(std::size_t bytes_to_read);
 
     virtual void set_pos(std::size_t pos) = 0;
 
     [[nodiscard]]
     virtual std::size_t get_pos() const noexcept = 0;
 
+    // owner of the memory returned by read()
+    // holding it keeps the returned pointers valid after the reader itself is gone
+    // readers which reuse their buffers return nullptr: nothing may point into them after the next read
+    [[nodiscard]]
+    virtual std::shared_ptr<const void> get_storage() const noexcept = 0;
+
+    // free the buffers owned by the reader (if any) until the next read
+    virtual void release() noexcept {
+    }
+
+    [[nodiscard]]
+    std::size_t get_len() const noexcept;
+
+    // true if there is nothing left to read
+    [[nodiscard]]
+    bool is_eof() const noexcept;
+
+    // compressed files (see decompress.h) are always decompressed into memory regardless of the type
     [[nodiscard]]
     static std::unique_ptr<reader> factory(reader_type type, const std::filesystem::path& path);
 
-    // split reader into several parallel readers
-    std::vector<std::unique_ptr<reader>> split(uint8_t num);
+    // move to the next occurence of pattern at or after pos. used to resync after corrupted data
+    // if there is none the reader is exhausted as if everything was read till eof and false is returned
+    bool resync(std::string_view pattern, std::size_t pos);
+
+    // stop at pos as if the data ended there. the rest is left for the next parse of a growing file
+    void hold(std::size_t pos) noexcept;
+
+    // split reader into num parallel readers over consecutive chunks of (almost) equal size
+    std::vector<std::unique_ptr<reader>> split(std::size_t num);
+
+    // the reader split(num)[index] would return, without the others
+    [[nodiscard]]
+    std::unique_ptr<reader> chunk(std::size_t index, std::size_t num) const;
+
+    // fresh reader over the same chunk starting at pos. used to reparse a part of the chunk
+    [[nodiscard]]
+    std::unique_ptr<reader> fork(std::size_t pos) const;
 
     std::size_t get_overrun() const;
     std::size_t get_first_valid_offset() const;
 
     // this is called after successful read
     // we use this only to capture first valid offset
+    // eof is not signalled here anymore, otherwise the last record of the file would be lost
     void notify_success(std::size_t offset);
 
+    // instrumentation of this reader (see stats.h). clones start from scratch
+    [[nodiscard]]
+    const io_stats& get_io_stats() const noexcept;
+
   protected:
+    // bookkeeping shared by try_read implementations: bounds check, chunk overrun and position update
+    // returns the position the requested bytes start at
+    [[nodiscard]]
+    expected<std::size_t> advance(std::size_t bytes_to_read) noexcept;
+
     std::size_t pos_{};
     std::size_t len_{};
     // for chunks which are being parsed in different threads overrun should be possible to handle borderline message
@@ -49,8 +104,13 @@ namespace dlt::fs {
     std::size_t overrun_ = 0;
     std::size_t current_offset_ = 0;
     std::size_t first_valid_offset_ = 0;
+    mutable io_stats io_stats_;
 
   private:
-    virtual std::unique_ptr<reader> clone() = 0;
+    virtual std::unique_ptr<reader> clone() const = 0;
+
+    // offset of the first occurence of pattern at or after pos, len_ if there is none
+    [[nodiscard]]
+    virtual std::size_t find(std::string_view pattern, std::size_t pos) const = 0;
   };
 }
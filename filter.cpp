@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include "filter.h"
+#include "conformance.h"
+#include "search.h"
+
+namespace dlt {
+  namespace {
+    bool contains(const std::vector<record_filter::id>& ids, const record_filter::id id) noexcept {
+      return ids.empty() || std::find(ids.cbegin(), ids.cend(), id) != ids.cend();
+    }
+
+    // formatting of verbose arguments copies strings verbatim and separates arguments by spaces. the rest of what
+    // it produces (numbers, hex of raw data, booleans) is made of these characters only. a needle without space
+    // and with anything else may only come from a single string argument, i.e. it is in the payload as is
+    bool isVerbatim(const std::string_view needle) noexcept {
+      constexpr std::string_view synthesized = "0123456789abcdefABCDEFxX+-.eEinftrulsa";
+      return needle.find(' ') == std::string_view::npos && needle.find_first_not_of(synthesized) != std::string_view::npos;
+    }
+
+    bool isWord(const char c) noexcept {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-'
+        || c == '.';
+    }
+
+    struct named_value {
+      std::string_view name;
+      int8_t value;
+    };
+
+    constexpr std::array<named_value, 4> TYPES{ {
+      { "log", static_cast<int8_t>(conformance::MsgType::TypeLog) },
+      { "app_trace", static_cast<int8_t>(conformance::MsgType::TypeAppTrace) },
+      { "nw_trace", static_cast<int8_t>(conformance::MsgType::TypeNwTrace) },
+      { "control", static_cast<int8_t>(conformance::MsgType::TypeControl) }
+    } };
+
+    constexpr std::array<named_value, 6> LEVELS{ {
+      { "fatal", static_cast<int8_t>(conformance::LogType::LogFatal) },
+      { "error", static_cast<int8_t>(conformance::LogType::LogError) },
+      { "warn", static_cast<int8_t>(conformance::LogType::LogWarn) },
+      { "info", static_cast<int8_t>(conformance::LogType::LogInfo) },
+      { "debug", static_cast<int8_t>(conformance::LogType::LogDebug) },
+      { "verbose", static_cast<int8_t>(conformance::LogType::LogVerbose) }
+    } };
+  }
+
+  // recursive descent straight into postfix
+  class filter_expression::parser final {
+  public:
+    parser(const std::string_view text, filter_expression& result) : text_(text), result_(result) {
+    }
+
+    void parse() {
+      expression();
+      if (!peek().empty()) {
+        fail("unexpected token");
+      }
+    }
+
+  private:
+    void expression() {
+      conjunction();
+      while (accept("or")) {
+        conjunction();
+        emit(opcode::disj);
+      }
+    }
+
+    void conjunction() {
+      unary();
+      while (accept("and")) {
+        unary();
+        emit(opcode::conj);
+      }
+    }
+
+    void unary() {
+      if (++nesting_ > MAX_DEPTH) {
+        fail("expression is nested too deep");
+      }
+
+      if (accept("not")) {
+        unary();
+        emit(opcode::neg);
+      }
+      else if (accept("(")) {
+        expression();
+        expect(")");
+      }
+      else {
+        comparison();
+      }
+      --nesting_;
+    }
+
+    void comparison() {
+      const auto target = fieldOf(next());
+      const bool isId = target == field::apid || target == field::ctid || target == field::ecu;
+
+      if (accept("in")) {
+        expect("{");
+        const auto begin = result_.sets_.size();
+        do {
+          result_.sets_.push_back(value(target));
+        } while (accept(","));
+        expect("}");
+
+        std::sort(result_.sets_.begin() + begin, result_.sets_.end());
+        result_.sets_.erase(std::unique(result_.sets_.begin() + begin, result_.sets_.end()), result_.sets_.end());
+        result_.program_.push_back({ opcode::in, target, static_cast<uint32_t>(result_.sets_.size() - begin),
+          static_cast<int64_t>(begin) });
+        return;
+      }
+
+      const auto token = next();
+      opcode op;
+      if (token == "==" || token == "=") {
+        op = opcode::eq;
+      }
+      else if (token == "!=") {
+        op = opcode::ne;
+      }
+      else if (!isId && token == "<") {
+        op = opcode::lt;
+      }
+      else if (!isId && token == "<=") {
+        op = opcode::le;
+      }
+      else if (!isId && token == ">") {
+        op = opcode::gt;
+      }
+      else if (!isId && token == ">=") {
+        op = opcode::ge;
+      }
+      else {
+        fail("comparison expected");
+      }
+      result_.program_.push_back({ op, target, 0, value(target) });
+    }
+
+    field fieldOf(const std::string_view token) {
+      if (token == "apid") {
+        return field::apid;
+      }
+      if (token == "ctid") {
+        return field::ctid;
+      }
+      if (token == "ecu") {
+        return field::ecu;
+      }
+      if (token == "type") {
+        return field::type;
+      }
+      if (token == "level") {
+        return field::level;
+      }
+      if (token == "time") {
+        return field::time;
+      }
+      fail("field expected");
+    }
+
+    int64_t value(const field target) {
+      auto token = next();
+      if (token.empty() || token == "," || token == "}" || token == ")") {
+        fail("value expected");
+      }
+
+      if (target == field::apid || target == field::ctid || target == field::ecu) {
+        if (token.size() >= 2 && (token.front() == '"' || token.front() == '\'')) {
+          token = token.substr(1, token.size() - 2);
+        }
+        if (token.size() > 4) {
+          fail("DLT id is longer than 4 characters");
+        }
+        return record_filter::make_id(token);
+      }
+
+      const auto names = [target]() -> std::pair<const named_value*, std::size_t> {
+        switch (target) {
+        case field::type:
+          return { TYPES.data(), TYPES.size() };
+        case field::level:
+          return { LEVELS.data(), LEVELS.size() };
+        default:
+          return { nullptr, 0 };
+        }
+      }();
+      for (std::size_t i = 0; i != names.second; ++i) {
+        if (names.first[i].name == token) {
+          return names.first[i].value;
+        }
+      }
+
+      int64_t number = 0;
+      for (const char c : token) {
+        if (c < '0' || c > '9') {
+          fail("number expected");
+        }
+        number = number * 10 + (c - '0');
+      }
+      return number;
+    }
+
+    void emit(const opcode op) {
+      result_.program_.push_back({ op, field::time, 0, 0 });
+    }
+
+    std::string_view peek() {
+      while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+        ++pos_;
+      }
+      start_ = pos_;
+      if (pos_ == text_.size()) {
+        return {};
+      }
+
+      auto end = pos_ + 1;
+      const char c = text_[pos_];
+      if (c == '"' || c == '\'') {
+        end = text_.find(c, end);
+        if (end == std::string_view::npos) {
+          fail("unterminated string");
+        }
+        ++end;
+      }
+      else if (isWord(c)) {
+        while (end < text_.size() && isWord(text_[end])) {
+          ++end;
+        }
+      }
+      else if ((c == '=' || c == '!' || c == '<' || c == '>') && end < text_.size() && text_[end] == '=') {
+        ++end;
+      }
+      return text_.substr(pos_, end - pos_);
+    }
+
+    std::string_view next() {
+      const auto token = peek();
+      pos_ += token.size();
+      return token;
+    }
+
+    bool accept(const std::string_view token) {
+      if (peek() != token) {
+        return false;
+      }
+      pos_ += token.size();
+      return true;
+    }
+
+    void expect(const std::string_view token) {
+      if (!accept(token)) {
+        fail(("'" + std::string(token) + "' expected").c_str());
+      }
+    }
+
+    [[noreturn]] void fail(const char* what) const {
+      throw std::invalid_argument("filter: " + std::string(what) + " at position " + std::to_string(start_));
+    }
+
+    std::string_view text_;
+    std::size_t pos_{ 0 };
+    // beginning of the last token, reported on errors
+    std::size_t start_{ 0 };
+    std::size_t nesting_{ 0 };
+    filter_expression& result_;
+  };
+
+  filter_expression filter_expression::compile(const std::string_view text) {
+    filter_expression result;
+    parser(text, result).parse();
+    return result;
+  }
+
+  bool filter_expression::evaluate(const filter_fields& fields) const noexcept {
+    // every level of nesting keeps at most the left operands of "or" and "and" pending
+    std::array<bool, 2 * MAX_DEPTH + 2> stack;
+    std::size_t top = 0;
+
+    for (const auto& instruction : program_) {
+      int64_t value = 0;
+      bool known = true;
+      switch (instruction.target) {
+      case field::apid:
+        value = fields.apid;
+        break;
+      case field::ctid:
+        value = fields.ctid;
+        break;
+      case field::ecu:
+        value = fields.ecu;
+        break;
+      case field::type:
+        value = fields.type;
+        break;
+      case field::level:
+        value = fields.subType;
+        known = fields.type == static_cast<int8_t>(conformance::MsgType::TypeLog)
+          && fields.subType >= static_cast<int8_t>(conformance::LogType::LogFatal);
+        break;
+      case field::time:
+        value = static_cast<int64_t>(fields.time);
+        break;
+      }
+
+      switch (instruction.op) {
+      case opcode::eq:
+        stack[top++] = known && value == instruction.value;
+        break;
+      case opcode::ne:
+        stack[top++] = known && value != instruction.value;
+        break;
+      case opcode::lt:
+        stack[top++] = known && value < instruction.value;
+        break;
+      case opcode::le:
+        stack[top++] = known && value <= instruction.value;
+        break;
+      case opcode::gt:
+        stack[top++] = known && value > instruction.value;
+        break;
+      case opcode::ge:
+        stack[top++] = known && value >= instruction.value;
+        break;
+      case opcode::in: {
+        // sets are small: a linear scan of a few integers beats hashing
+        const auto begin = sets_.cbegin() + instruction.value;
+        const auto end = begin + instruction.count;
+        stack[top++] = known && (instruction.count <= 8 ? std::find(begin, end, value) != end
+          : std::binary_search(begin, end, value));
+        break;
+      }
+      case opcode::conj:
+        --top;
+        stack[top - 1] = stack[top - 1] && stack[top];
+        break;
+      case opcode::disj:
+        --top;
+        stack[top - 1] = stack[top - 1] || stack[top];
+        break;
+      case opcode::neg:
+        stack[top - 1] = !stack[top - 1];
+        break;
+      }
+    }
+    return top != 0 && stack[0];
+  }
+
+  record_filter::id record_filter::make_id(const std::string_view str) {
+    char value[sizeof(id)]{};
+    if (str.size() > sizeof(value)) {
+      throw std::invalid_argument("DLT id is longer than 4 characters");
+    }
+    std::copy(str.cbegin(), str.cend(), value);
+
+    id result;
+    ::memcpy(&result, value, sizeof(result));
+    return result;
+  }
+
+  bool record_filter::matches(const filter_fields& fields) const noexcept {
+    if (fields.time < time_from || fields.time > time_to) {
+      return false;
+    }
+    if (type && *type != fields.type) {
+      return false;
+    }
+    if (max_level && (fields.type != static_cast<int8_t>(conformance::MsgType::TypeLog)
+      || fields.subType < static_cast<int8_t>(conformance::LogType::LogFatal) || fields.subType > *max_level)) {
+      return false;
+    }
+    return contains(apids, fields.apid) && contains(ctids, fields.ctid) && contains(ecus, fields.ecu)
+      && (!expression || expression->evaluate(fields));
+  }
+
+  bool record_filter::mayContain(const uint8_t* payload, const std::size_t len, const bool isVerbose) const noexcept {
+    if (text.empty() || !isVerbose || !isVerbatim(text)) {
+      return true;
+    }
+    return search::find(reinterpret_cast<const char*>(payload), len, text, 0) < len;
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace dlt {
+  // header fields of a record a filter looks at. ids are the raw 4 bytes read as an integer (see record_filter::make_id)
+  struct filter_fields {
+    using microseconds = uint64_t;
+
+    uint32_t ecu;
+    uint32_t apid;
+    uint32_t ctid;
+    int8_t type;
+    int8_t subType;
+    microseconds time;
+  };
+
+  // predicate compiled once into a postfix program over integer compares
+  // grammar (keywords are lowercase):
+  //   expr  := and {"or" and}
+  //   and   := unary {"and" unary}
+  //   unary := "not" unary | "(" expr ")" | field op value | field "in" "{" value {"," value} "}"
+  //   field := apid | ctid | ecu | type | level | time
+  //   op    := "==" | "=" | "!=" | "<" | "<=" | ">" | ">="   (ids are only compared for (in)equality)
+  // ids are words or quoted strings of up to 4 characters. type is a number or log/app_trace/nw_trace/control,
+  // level is a number or fatal/error/warn/info/debug/verbose, time is the storage header time in microseconds
+  // level of a non-log message is unknown: every comparison of it is false, negation is true then
+  class filter_expression final {
+  public:
+    // throws std::invalid_argument with the position of a syntax error
+    [[nodiscard]] static filter_expression compile(std::string_view text);
+
+    [[nodiscard]] bool evaluate(const filter_fields& fields) const noexcept;
+
+  private:
+    class parser;
+
+    enum class field : uint8_t {
+      apid,
+      ctid,
+      ecu,
+      type,
+      level,
+      time
+    };
+
+    enum class opcode : uint8_t {
+      /* push result of the comparison of the field with the value */
+      eq,
+      ne,
+      lt,
+      le,
+      gt,
+      ge,
+      /* push whether the field is in sets_[value, value + count) */
+      in,
+      /* pop two, push the result */
+      conj,
+      disj,
+      /* replace the top */
+      neg
+    };
+
+    struct instruction {
+      opcode op;
+      field target;
+      uint32_t count;
+      int64_t value;
+    };
+
+    // expressions nested deeper are rejected by compile
+    static constexpr std::size_t MAX_DEPTH = 32;
+
+    std::vector<instruction> program_;
+    // values of all the sets one after another, each one sorted
+    std::vector<int64_t> sets_;
+  };
+
+  // conditions checked right after the headers of a record are read (see parse_options::filter)
+  // records which do not match are neither formatted nor stored. all the conditions must hold
+  struct record_filter {
+    using id = uint32_t;
+    using microseconds = uint64_t;
+
+    // any of. empty matches all
+    std::vector<id> apids;
+    std::vector<id> ctids;
+    std::vector<id> ecus;
+    // DLT message type (conformance::MsgType)
+    std::optional<int8_t> type;
+    // only log messages of this level or more severe (conformance::LogType, fatal is the lowest)
+    std::optional<int8_t> max_level;
+    // storage header time, inclusive
+    microseconds time_from = 0;
+    microseconds time_to = std::numeric_limits<microseconds>::max();
+    // checked after all the above
+    std::optional<filter_expression> expression;
+    // substring of the formatted message. checked last: the raw payload is scanned first where it is conclusive,
+    // so only the records with a candidate hit are formatted. such records are never lazy
+    std::string text;
+
+    // ids are padded with null-characters. throws std::invalid_argument for ids longer than 4 characters
+    [[nodiscard]] static id make_id(std::string_view str);
+
+    [[nodiscard]] bool matches(const filter_fields& fields) const noexcept;
+    // false if the message of the record surely does not contain text. true otherwise (and if there is no text)
+    [[nodiscard]] bool mayContain(const uint8_t* payload, std::size_t len, bool isVerbose) const noexcept;
+  };
+}
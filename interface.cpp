@@ -1,33 +1,297 @@
 #include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include <boost/dll.hpp>
 #include <rostrum/api.hpp>
 
 #include "filereader.h"
+#include "decompress.h"
 #include "exceptions.h"
 #include "record.h"
+#include "record_table.h"
+#include "segmented_table.h"
+#include "merged_table.h"
+#include "filter.h"
+#include "catalog.h"
+#include "record_index.h"
+#include "time_index.h"
+#include "record_stream.h"
 #include "thread_supervisor.h"
+#include "thread_pool.h"
+#include "background_parse.h"
 
 /* for lld */
 #ifdef __llvm__
 # pragma comment(lib, "lua")
 # pragma comment(lib, "fmt")
 #	pragma comment(lib, "boost_iostreams-vc140-mt")
+# ifdef DLT_WITH_GZIP
+#  pragma comment(lib, "zlib")
+# endif
+# ifdef DLT_WITH_XZ
+#  pragma comment(lib, "lzma")
+# endif
+# ifdef DLT_WITH_ZSTD
+#  pragma comment(lib, "zstd")
+# endif
 #endif
 
+namespace {
+  // either an expression (see dlt::filter_expression) or
+  // { apid = "DIAG" or { "DIAG", "SYS" }, ctid = ..., ecu = ..., type = 0, max_level = 3, from = us, to = us,
+  //   text = substring of the message, where = expression }
+  std::shared_ptr<const dlt::record_filter> make_filter(const sol::object& object) {
+    if (object.is<std::string>()) {
+      auto filter = std::make_shared<dlt::record_filter>();
+      filter->expression = dlt::filter_expression::compile(object.as<std::string>());
+      return filter;
+    }
+    const auto spec = object.as<sol::optional<sol::table>>();
+    if (!spec) {
+      return nullptr;
+    }
+
+    const auto ids = [&spec](const char* key) {
+      std::vector<dlt::record_filter::id> result;
+      const sol::object value = (*spec)[key];
+      if (value.is<std::string>()) {
+        result.push_back(dlt::record_filter::make_id(value.as<std::string>()));
+      }
+      else if (value.is<sol::table>()) {
+        for (const auto& [_, id] : value.as<sol::table>()) {
+          result.push_back(dlt::record_filter::make_id(id.as<std::string>()));
+        }
+      }
+      return result;
+    };
+
+    auto filter = std::make_shared<dlt::record_filter>();
+    filter->apids = ids("apid");
+    filter->ctids = ids("ctid");
+    filter->ecus = ids("ecu");
+    filter->type = (*spec)["type"].get<sol::optional<int8_t>>();
+    filter->max_level = (*spec)["max_level"].get<sol::optional<int8_t>>();
+    filter->time_from = (*spec)["from"].get_or(filter->time_from);
+    filter->time_to = (*spec)["to"].get_or(filter->time_to);
+    filter->text = (*spec)["text"].get_or(std::string{});
+    if (const auto where = (*spec)["where"].get<sol::optional<std::string>>()) {
+      filter->expression = dlt::filter_expression::compile(*where);
+    }
+    return filter;
+  }
+
+  // compiled once and cached in <file>.cat, see dlt::index::load_catalog. nil removes the catalog
+  std::shared_ptr<const dlt::MessageCatalog> make_catalog(const sol::optional<std::string>& path) {
+    if (!path) {
+      return nullptr;
+    }
+    if (!std::filesystem::exists(*path)) {
+      throw std::runtime_error("FIBEX file not found");
+    }
+    if (auto&& cached = dlt::index::load_catalog(*path)) {
+      return std::make_shared<const dlt::MessageCatalog>(std::move(*cached));
+    }
+    auto catalog = std::make_shared<const dlt::MessageCatalog>(dlt::MessageCatalog::loadFibex(*path));
+    static_cast<void>(dlt::index::save(*path, *catalog));
+    return catalog;
+  }
+
+  double milliseconds(const dlt::nanoseconds time) {
+    return static_cast<double>(time) / 1e6;
+  }
+
+  // { enabled = built with DLT_WITH_STATS, total_ms, merge_ms, reparsed_bytes, reparsed_filtered, reparsed_format_ms,
+  //   tasks = { { begin, end, parsed_until, overrun, records, corrupted, filtered, resync_bytes, io_wait_ms, format_ms,
+  //   parse_ms }, ... } }
+  sol::table to_lua(sol::state_view lua, const dlt::parse_stats& stats) {
+    auto tasks = lua.create_table(static_cast<int>(stats.tasks.size()), 0);
+    for (std::size_t i = 0; i != stats.tasks.size(); ++i) {
+      const auto& task = stats.tasks[i];
+      tasks[i + 1] = lua.create_table_with(
+        "begin", task.begin,
+        "end", task.end,
+        "parsed_until", task.parsed_until,
+        "overrun", task.overrun,
+        "records", task.records,
+        "corrupted", task.corrupted,
+        "filtered", task.table.filtered,
+        "resync_bytes", task.io.resync_bytes,
+        "io_wait_ms", milliseconds(task.io.wait),
+        "format_ms", milliseconds(task.table.format),
+        "parse_ms", milliseconds(task.parse));
+    }
+    return lua.create_table_with(
+      "enabled", dlt::parse_stats::enabled,
+      "total_ms", milliseconds(stats.total),
+      "merge_ms", milliseconds(stats.merge),
+      "reparsed_bytes", stats.reparsed_bytes,
+      "reparsed_filtered", stats.reparsed.filtered,
+      "reparsed_format_ms", milliseconds(stats.reparsed.format),
+      "tasks", tasks);
+  }
+
+  // fills the lua array with get(table, row) of rows [from, to) in one pass over the segments
+  template <typename Get>
+  sol::table make_column(sol::state_view lua, const dlt::SegmentedTable& table, const std::size_t from,
+    const std::size_t to, Get&& get) {
+    auto column = lua.create_table(static_cast<int>(to - from), 0);
+    std::size_t i = 1;
+    table.forEachRange(from, to, [&](const dlt::RecordTable& segment, const std::size_t begin, const std::size_t end) {
+      for (auto row = begin; row != end; ++row) {
+        column.raw_set(i++, get(segment, row));
+      }
+    });
+    return column;
+  }
+
+  // ids repeat a lot: every distinct one is made a lua string once, rows get a reference to it
+  template <typename Key>
+  sol::table make_id_column(sol::state_view lua, const dlt::SegmentedTable& table, const std::size_t from,
+    const std::size_t to, Key key) {
+    std::unordered_map<std::string_view, sol::object> strings;
+    // keys are interned per segment
+    std::vector<const sol::object*> interned;
+    auto column = lua.create_table(static_cast<int>(to - from), 0);
+    std::size_t i = 1;
+    table.forEachRange(from, to, [&](const dlt::RecordTable& segment, const std::size_t begin, const std::size_t end) {
+      interned.assign(segment.idsNum(), nullptr);
+      for (auto row = begin; row != end; ++row) {
+        auto& string = interned[(segment.*key)(row)];
+        if (string == nullptr) {
+          const auto id = segment.getId((segment.*key)(row));
+          string = &strings.try_emplace(id, sol::make_object(lua, id)).first->second;
+        }
+        column.raw_set(i++, *string);
+      }
+    });
+    return column;
+  }
+
+  // one of: timestamp, timestamp_extra, sessionid, counter, type, subtype, apid, ctid, ecu, message, corrupted
+  sol::table make_column(sol::state_view lua, const dlt::SegmentedTable& table, const std::string_view name,
+    const std::size_t from, const std::size_t to) {
+    using dlt::RecordTable;
+    if (name == "timestamp") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getTimeStamp(row); });
+    }
+    if (name == "timestamp_extra") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getTimestampExtra(row); });
+    }
+    if (name == "sessionid") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getSessionId(row); });
+    }
+    if (name == "counter") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getMessageCounter(row); });
+    }
+    if (name == "type") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getType(row); });
+    }
+    if (name == "subtype") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getSubType(row); });
+    }
+    if (name == "apid") {
+      return make_id_column(lua, table, from, to, &RecordTable::getApidKey);
+    }
+    if (name == "ctid") {
+      return make_id_column(lua, table, from, to, &RecordTable::getCtidKey);
+    }
+    if (name == "ecu") {
+      return make_id_column(lua, table, from, to, &RecordTable::getEcuKey);
+    }
+    if (name == "message") {
+      // the same as get_message: lazy messages are formatted, corrupted rows are empty
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.getMessage(row); });
+    }
+    if (name == "corrupted") {
+      return make_column(lua, table, from, to, [](const RecordTable& t, const std::size_t row) { return t.isCorrupted(row); });
+    }
+    throw std::invalid_argument("unknown column: " + std::string(name));
+  }
+}
+
 class dlt_file_adapter {
 private:
-  std::vector<dlt::Record> records;
+  dlt::SegmentedTable table_;
+  std::filesystem::path path_;
+  dlt::parse_options options_;
+  bool use_index_{ false };
+  unsigned threads_num_{ 0 };
+  dlt::fs::reader_type parse_reader_{ dlt::fs::reader_type::file_precache };
+  // end of the data which is already in table_. the held tail of a growing file starts here
+  std::size_t parsed_until_{ 0 };
+  // built by the first seek_time since the last parse/poll
+  std::optional<dlt::TimeIndex> time_index_;
+  // table_ holds rows of all the records as seek_time parses them: nothing is filtered or held
+  bool indexable_{ false };
+  // of the last parse which was not served by the index
+  dlt::parse_stats stats_;
+  // started by parse_async. its records are moved to table_ by the first call which needs all of them
+  std::unique_ptr<dlt::background_parse> background_;
+  // the index is written once the background parse is joined
+  bool save_index_{ false };
 public:
-  void parse(const std::string& filename) {
+  // defer payload formatting until get_message is called. affects subsequent parse/records calls
+  void set_lazy_messages(const bool lazy) {
+    options_.lazy_message = lazy;
+  }
+
+  // reuse <file>.idx on parse if it is up to date, otherwise write it after parsing
+  void set_index(const bool use_index) {
+    use_index_ = use_index;
+  }
+
+  // number of parsing threads, 0 (default) is one per core
+  void set_threads(const unsigned threads_num) {
+    threads_num_ = threads_num;
+  }
+
+  // read the file through bounded read-ahead buffers on parse instead of loading it into memory at once
+  // messages are formatted eagerly then: nothing may point into the reused buffers
+  void set_streaming(const bool streaming) {
+    parse_reader_ = streaming ? dlt::fs::reader_type::file_stream : dlt::fs::reader_type::file_precache;
+  }
+
+  // the file is still being written. a record cut by the end of file is left for poll instead of being
+  // reported as corrupted. the index is not used for such files: it is outdated as soon as the file grows
+  void set_follow(const bool follow) {
+    options_.hold_tail = follow;
+  }
+
+  // records not matching the filter are skipped while parsing: they are neither formatted nor stored
+  // nil removes the filter. affects subsequent parse/poll/records calls. the index is not used with a filter
+  void set_filter(const sol::object& spec) {
+    options_.filter = make_filter(spec);
+  }
+
+  // decode non-verbose messages by the FIBEX file. affects subsequent parse/poll/records calls
+  // the index is not used with a catalog: it keeps no messages, so they would be decoded without it
+  void set_catalog(const sol::optional<std::string>& path) {
+    options_.catalog = make_catalog(path);
+  }
+
+  // remember the file without parsing it. used by streaming access
+  void open(const std::string& filename) {
     if (!std::filesystem::exists(filename)) {
       throw std::runtime_error("DLT file not found");
     }
-    auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_precache, filename);
+    path_ = filename;
+  }
+
+  void parse(const std::string& filename) {
+    const bool indexed = is_indexed();
+    if (restart(filename, indexed)) {
+      return;
+    }
+
+    auto&& reader = dlt::fs::reader::factory(parse_reader_, filename);
     //if (dlt::supervisor::cores_num > 1) 
     {
       try {
-        dlt::supervisor supervisor(std::move(*reader));
-        supervisor.execute(records);
+        dlt::supervisor supervisor(std::move(*reader), options_, threads_num_);
+        parsed_until_ = supervisor.execute(table_);
+        stats_ = supervisor.stats();
+        indexable_ = options_.filter == nullptr && !options_.hold_tail;
       }
       catch(const dlt::except::eof&) {
         // file len is 0
@@ -46,30 +310,402 @@ public:
         }
       }
     }*/
+
+    if (indexed) {
+      static_cast<void>(dlt::index::save(path_, table_));
+    }
   }
 
-  [[nodiscard]] auto records_num() const {
-    return records.size();
+  // the same as parse but returns right away: the file is parsed in the background meanwhile
+  // records_num is the number of records available so far (they are the first ones of the file) and
+  // get_record waits for the record if it is not parsed yet. the rest of the calls wait for the whole parse
+  void parse_async(const std::string& filename) {
+    const bool indexed = is_indexed();
+    if (restart(filename, indexed) || std::filesystem::file_size(path_) == 0) {
+      return;
+    }
+
+    auto&& reader = dlt::fs::reader::factory(parse_reader_, filename);
+    try {
+      background_ = std::make_unique<dlt::background_parse>(std::move(*reader), options_, threads_num_);
+    }
+    catch (const dlt::except::eof&) {
+      // the file decompresses to nothing
+      return;
+    }
+    save_index_ = indexed;
+  }
+
+  [[nodiscard]] bool is_parsing() const {
+    return background_ != nullptr && !background_->done();
+  }
+
+  // fraction of the file parse_async has covered so far
+  [[nodiscard]] double progress() const {
+    return background_ != nullptr ? background_->progress() : 1.0;
+  }
+
+  // waits for parse_async to finish. rethrows its error if it failed
+  void wait() {
+    if (background_ == nullptr) {
+      return;
+    }
+    // the parse is over once handed over, even if it failed
+    const auto background = std::move(background_);
+    parsed_until_ = background->finish(table_);
+    stats_ = background->stats();
+    indexable_ = options_.filter == nullptr && !options_.hold_tail;
+    if (save_index_) {
+      static_cast<void>(dlt::index::save(path_, table_));
+    }
+  }
+
+  // parse the data appended to the file since the last parse/poll. returns the number of new records
+  // growth is detected by the file size, so it is up to the caller how often to poll
+  // truncated (e.g. rotated) file is parsed from scratch. compressed files cannot be polled
+  std::size_t poll() {
+    if (path_.empty()) {
+      throw std::runtime_error("DLT file is not opened");
+    }
+    // parsed_until_ is an offset into the decompressed data, the size on disk tells nothing about it
+    if (dlt::fs::detect_compression(path_) != dlt::fs::compression::none) {
+      throw std::runtime_error("compressed DLT file cannot be polled");
+    }
+    wait();
+
+    const auto size = std::filesystem::file_size(path_);
+    if (size < parsed_until_) {
+      parse(path_.string());
+      return table_.size();
+    }
+    if (size == parsed_until_) {
+      return 0;
+    }
+
+    // mapping is enough: only the pages of the appended data are touched
+    // (a mapped file cannot be truncated on Windows, rotation by rename keeps the mapped content alive)
+    auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path_);
+    reader->set_pos(parsed_until_);
+
+    auto options = options_;
+    options.hold_tail = true;
+    auto table = std::make_shared<dlt::RecordTable>();
+    while (table->try_parse(*reader, options) != dlt::errc::eof) {
+    }
+
+    parsed_until_ = reader->get_pos();
+    const auto before = table_.size();
+    table_.splice(std::move(table));
+    time_index_.reset();
+    indexable_ = false;
+    return table_.size() - before;
+  }
+
+  // records with the storage header time in [from, to] (microseconds) in file order, the filter applies as well
+  // only the window holding them is parsed and messages are lazy. the time index is built by the first call from
+  // the parsed records (or by a parse of the whole file if they do not fit) or loaded from <file>.tidx if the
+  // index is enabled
+  [[nodiscard]] std::vector<dlt::Record> seek_time(const uint64_t from, const uint64_t to) {
+    if (path_.empty()) {
+      throw std::runtime_error("DLT file is not opened");
+    }
+    if (std::filesystem::file_size(path_) == 0) {
+      return {};
+    }
+
+    wait();
+    if (!time_index_ && use_index_) {
+      time_index_ = dlt::index::load_time(path_);
+    }
+    if (!time_index_) {
+      if (indexable_) {
+        time_index_.emplace(table_, parsed_until_);
+      }
+      else {
+        auto options = options_;
+        options.filter = nullptr;
+        options.hold_tail = false;
+        options.lazy_message = true;
+        auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path_);
+        dlt::SegmentedTable table;
+        dlt::supervisor supervisor(std::move(*reader), options, threads_num_);
+        time_index_.emplace(table, supervisor.execute(table));
+      }
+      if (use_index_) {
+        static_cast<void>(dlt::index::save(path_, *time_index_));
+      }
+    }
+
+    const auto window = time_index_->find(from, to);
+    if (window.begin_offset == window.end_offset) {
+      return {};
+    }
+
+    auto filter = std::make_shared<dlt::record_filter>(options_.filter != nullptr ? *options_.filter : dlt::record_filter{});
+    filter->time_from = std::max<uint64_t>(filter->time_from, from);
+    filter->time_to = std::min<uint64_t>(filter->time_to, to);
+    auto options = options_;
+    options.filter = std::move(filter);
+    options.lazy_message = true;
+    options.hold_tail = false;
+
+    auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path_);
+    reader->set_pos(window.begin_offset);
+    auto table = std::make_shared<dlt::RecordTable>();
+    while (reader->get_pos() < window.end_offset && table->try_parse(*reader, options) != dlt::errc::eof) {
+    }
+
+    std::vector<dlt::Record> records;
+    records.reserve(table->size());
+    for (std::size_t i = 0; i != table->size(); ++i) {
+      records.emplace_back(table, i);
+    }
+    return records;
   }
 
-  [[nodiscard]] const auto & get_record(const size_t index) const {
-    return records[index];
+  // records whose message contains text, the filter applies as well. the file is parsed by all the threads
+  // but only records with a hit in the raw payload are formatted (see dlt::record_filter::text)
+  [[nodiscard]] std::vector<dlt::Record> search(const std::string& text) const {
+    if (path_.empty()) {
+      throw std::runtime_error("DLT file is not opened");
+    }
+    if (std::filesystem::file_size(path_) == 0) {
+      return {};
+    }
+
+    auto filter = std::make_shared<dlt::record_filter>(options_.filter != nullptr ? *options_.filter : dlt::record_filter{});
+    filter->text = text;
+    auto options = options_;
+    options.filter = std::move(filter);
+    options.hold_tail = false;
+
+    auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path_);
+    dlt::SegmentedTable table;
+    dlt::supervisor supervisor(std::move(*reader), options, threads_num_);
+    static_cast<void>(supervisor.execute(table));
+
+    std::vector<dlt::Record> records;
+    records.reserve(table.size());
+    for (std::size_t i = 0; i != table.size(); ++i) {
+      records.push_back(table.get(i));
+    }
+    return records;
+  }
+
+  // lua iterator: for rec in file:records() do ... end
+  // records are parsed lazily in batches of batch_size, nothing is stored in the adapter
+  [[nodiscard]] dlt::stream records(const sol::optional<std::size_t> batch_size) const {
+    if (path_.empty()) {
+      throw std::runtime_error("DLT file is not opened");
+    }
+    // mapping keeps memory flat for huge files; empty files cannot be mapped
+    const auto type = std::filesystem::file_size(path_) > 0 ? dlt::fs::reader_type::file_map : dlt::fs::reader_type::file_precache;
+    return dlt::stream(dlt::fs::reader::factory(type, path_), batch_size.value_or(dlt::stream::DEFAULT_BATCH_SIZE),
+      options_);
+  }
+
+  [[nodiscard]] std::size_t records_num() {
+    if (background_ != nullptr) {
+      if (!background_->done()) {
+        return background_->size();
+      }
+      wait();
+    }
+    return table_.size();
+  }
+
+  [[nodiscard]] dlt::Record get_record(const size_t index) {
+    if (background_ != nullptr) {
+      if (auto&& record = background_->get(index)) {
+        return std::move(*record);
+      }
+      // the parse is over without reaching the record
+      wait();
+    }
+    if (index >= table_.size()) {
+      throw std::out_of_range("record index is out of range");
+    }
+    return table_.get(index);
+  }
+
+  // values of one field of records [from, to) (0-based as get_record, the whole table by default) as a lua array
+  // one call instead of a get_record and a getter per record. see make_column for the names
+  [[nodiscard]] sol::table column(const std::string& name, const sol::optional<std::size_t> from,
+    const sol::optional<std::size_t> to, const sol::this_state state) {
+    wait();
+    const auto end = to.value_or(table_.size());
+    const auto begin = from.value_or(0);
+    if (begin > end || end > table_.size()) {
+      throw std::out_of_range("record range is out of range");
+    }
+    return make_column(sol::state_view(state), table_, name, begin, end);
+  }
+
+  [[nodiscard]] sol::table timestamps(const sol::optional<std::size_t> from, const sol::optional<std::size_t> to,
+    const sol::this_state state) {
+    return column("timestamp", from, to, state);
+  }
+
+  // per chunk counters of the last parse, e.g. to spot the load imbalance across the threads
+  // the timers and some of the counters are zero unless built with DLT_WITH_STATS (see stats.h)
+  [[nodiscard]] sol::table stats(const sol::this_state state) {
+    wait();
+    return to_lua(sol::state_view(state), stats_);
+  }
+
+private:
+  [[nodiscard]] bool is_indexed() const {
+    return use_index_ && !options_.hold_tail && options_.filter == nullptr && options_.catalog == nullptr;
+  }
+
+  // forgets everything about the previous file (a background parse of it is cancelled)
+  // returns true if the records are loaded from the index, otherwise the table is left empty
+  bool restart(const std::string& filename, const bool indexed) {
+    background_.reset();
+    save_index_ = false;
+    open(filename);
+    parsed_until_ = 0;
+    time_index_.reset();
+    indexable_ = false;
+    stats_ = {};
+    if (indexed && std::filesystem::file_size(path_) > 0) {
+      // mapping is enough: only records which are actually accessed are touched
+      auto&& mapped = dlt::fs::reader::factory(dlt::fs::reader_type::file_map, path_);
+      if (auto&& table = dlt::index::load(path_, *mapped)) {
+        table_ = std::move(*table);
+        parsed_until_ = mapped->get_len();
+        // the index is only saved of a parse which holds all the records
+        indexable_ = true;
+        return true;
+      }
+    }
+    // records handed out before keep their segments alive
+    table_ = {};
+    return false;
   }
 };
 
 
+// several files (e.g. of different ECUs) as one sequence ordered by the storage header time
+class dlt_files_adapter {
+private:
+  dlt::MergedTable table_;
+  dlt::parse_options options_;
+  unsigned threads_num_{ 0 };
+public:
+  void set_lazy_messages(const bool lazy) {
+    options_.lazy_message = lazy;
+  }
+
+  void set_threads(const unsigned threads_num) {
+    threads_num_ = threads_num;
+  }
+
+  void set_filter(const sol::object& spec) {
+    options_.filter = make_filter(spec);
+  }
+
+  void set_catalog(const sol::optional<std::string>& path) {
+    options_.catalog = make_catalog(path);
+  }
+
+  // all the files are parsed at once and merged. empty files are skipped
+  void parse(const sol::table& filenames) {
+    std::vector<dlt::supervisor> supervisors;
+    std::vector<std::size_t> sources;
+    for (std::size_t i = 1; i <= filenames.size(); ++i) {
+      const std::string filename = filenames[i];
+      if (!std::filesystem::exists(filename)) {
+        throw std::runtime_error("DLT file not found");
+      }
+      if (std::filesystem::file_size(filename) == 0) {
+        continue;
+      }
+      auto&& reader = dlt::fs::reader::factory(dlt::fs::reader_type::file_precache, filename);
+      supervisors.emplace_back(std::move(*reader), options_, threads_num_);
+      sources.push_back(i - 1);
+    }
+
+    // records handed out before keep their segments alive
+    table_ = {};
+    std::vector<dlt::SegmentedTable> tables(filenames.size());
+    std::vector<dlt::SegmentedTable> parsed;
+    static_cast<void>(dlt::supervisor::execute(supervisors, parsed));
+    for (std::size_t i = 0; i != parsed.size(); ++i) {
+      tables[sources[i]] = std::move(parsed[i]);
+    }
+    table_ = dlt::MergedTable(std::move(tables));
+  }
+
+  [[nodiscard]] auto records_num() const {
+    return table_.size();
+  }
+
+  [[nodiscard]] dlt::Record get_record(const size_t index) const {
+    if (index >= table_.size()) {
+      throw std::out_of_range("record index is out of range");
+    }
+    return table_.get(index);
+  }
+
+  // 1-based position of the file in the list passed to parse
+  [[nodiscard]] std::size_t get_source(const size_t index) const {
+    if (index >= table_.size()) {
+      throw std::out_of_range("record index is out of range");
+    }
+    return table_.getSource(index) + 1;
+  }
+};
+
 sol::table imbue_lua(sol::state_view& lua) {
+  // start the workers along with the module, so the first parse does not pay for it
+  static_cast<void>(dlt::thread_pool::instance());
+
   auto table = lua.create_table();
 
   static_cast<void>(table.new_usertype<dlt_file_adapter>("dlt_file",
+    "set_lazy_messages", &dlt_file_adapter::set_lazy_messages,
+    "set_index", &dlt_file_adapter::set_index,
+    "set_threads", &dlt_file_adapter::set_threads,
+    "set_streaming", &dlt_file_adapter::set_streaming,
+    "set_follow", &dlt_file_adapter::set_follow,
+    "set_filter", &dlt_file_adapter::set_filter,
+    "set_catalog", &dlt_file_adapter::set_catalog,
+    "open", &dlt_file_adapter::open,
     "parse", &dlt_file_adapter::parse,
+    "parse_async", &dlt_file_adapter::parse_async,
+    "is_parsing", &dlt_file_adapter::is_parsing,
+    "progress", &dlt_file_adapter::progress,
+    "wait", &dlt_file_adapter::wait,
+    "poll", &dlt_file_adapter::poll,
+    "seek_time", &dlt_file_adapter::seek_time,
+    "search", &dlt_file_adapter::search,
+    "records", &dlt_file_adapter::records,
     "records_num", &dlt_file_adapter::records_num,
-    "get_record", &dlt_file_adapter::get_record));
+    "get_record", &dlt_file_adapter::get_record,
+    "column", &dlt_file_adapter::column,
+    "timestamps", &dlt_file_adapter::timestamps,
+    "stats", &dlt_file_adapter::stats));
+
+  static_cast<void>(table.new_usertype<dlt_files_adapter>("dlt_files",
+    "set_lazy_messages", &dlt_files_adapter::set_lazy_messages,
+    "set_threads", &dlt_files_adapter::set_threads,
+    "set_filter", &dlt_files_adapter::set_filter,
+    "set_catalog", &dlt_files_adapter::set_catalog,
+    "parse", &dlt_files_adapter::parse,
+    "records_num", &dlt_files_adapter::records_num,
+    "get_record", &dlt_files_adapter::get_record,
+    "get_source", &dlt_files_adapter::get_source));
+
+  // generic-for calls the iterator with (state, control) which are simply ignored
+  static_cast<void>(table.new_usertype<dlt::stream>("dlt_stream",
+    sol::meta_function::call, &dlt::stream::next,
+    "next", &dlt::stream::next));
 
   static_cast<void>(table.new_usertype<dlt::Record>("",
     "is_corrupted", &dlt::Record::isCorrupted,
     "get_corruption_cause", &dlt::Record::getCorruptionCause,
-    "get_message", &dlt::Record::getMessage,
+    "get_message", &dlt::Record::getMessageView,
     "get_apid", &dlt::Record::getApid,
     "get_ctid", &dlt::Record::getCtid,
     "get_timestamp", &dlt::Record::getTimeStamp,
@@ -6,6 +6,8 @@
 #include <stdexcept>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <utility>
 
 namespace dlt::lazy {
 
@@ -48,8 +50,8 @@ namespace dlt::lazy {
       std::string evaluated_string;
 
       // 1st iteration: calc length
-      const auto string_length = std::reduce(parts_.cbegin(), parts_.cend(), 0U,
-                                             [](const decltype(parts_)::size_type& length,
+      const auto string_length = std::accumulate(parts_.cbegin(), parts_.cend(), std::size_t{ 0 },
+                                             [](const std::size_t length,
                                                 const std::string_view string) {
                                                return length + std::size<std::string_view>(string);
                                              });
@@ -63,4 +65,31 @@ namespace dlt::lazy {
       return evaluated_string;
     }
   };
+
+  // evaluate-once holder: the value is produced by the first get() and reused afterwards
+  // unlike string above it does not own the evaluator, so the holder itself stays small
+  template <typename T>
+  class once final {
+  private:
+    std::optional<T> value_;
+
+  public:
+    [[nodiscard]]
+    bool is_evaluated() const noexcept {
+      return value_.has_value();
+    }
+
+    template <typename Evaluator>
+    const T& get(Evaluator&& evaluator) {
+      if (!value_.has_value()) {
+        value_.emplace(std::forward<Evaluator>(evaluator)());
+      }
+      return *value_;
+    }
+
+    template <typename U>
+    void set(U&& value) {
+      value_.emplace(std::forward<U>(value));
+    }
+  };
 }
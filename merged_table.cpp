@@ -0,0 +1,59 @@
+#include <cassert>
+#include <queue>
+#include <tuple>
+#include <limits>
+
+#include "merged_table.h"
+
+namespace dlt {
+  MergedTable::MergedTable(std::vector<SegmentedTable>&& tables) : tables_(std::move(tables)) {
+    assert(tables_.size() <= std::numeric_limits<uint32_t>::max());
+
+    std::size_t total = 0;
+    for (const auto& table : tables_) {
+      total += table.size();
+    }
+    source_.reserve(total);
+    row_.reserve(total);
+
+    // head of every file: time, file, row. the smallest one on top
+    using head = std::tuple<RecordTable::microseconds, uint32_t, std::size_t>;
+    std::priority_queue<head, std::vector<head>, std::greater<>> heads;
+    const auto push = [this, &heads](const uint32_t source, const std::size_t row) {
+      if (row < tables_[source].size()) {
+        const auto [table, index] = tables_[source].locate(row);
+        heads.emplace(table.getTimeStamp(index), source, row);
+      }
+    };
+
+    for (uint32_t source = 0; source != tables_.size(); ++source) {
+      push(source, 0);
+    }
+    while (!heads.empty()) {
+      const auto [time, source, row] = heads.top();
+      heads.pop();
+      source_.push_back(source);
+      row_.push_back(row);
+      push(source, row + 1);
+    }
+  }
+
+  std::size_t MergedTable::size() const noexcept {
+    return row_.size();
+  }
+
+  Record MergedTable::get(const std::size_t index) const {
+    assert(index < size());
+    return tables_[source_[index]].get(row_[index]);
+  }
+
+  std::size_t MergedTable::getSource(const std::size_t index) const {
+    assert(index < size());
+    return source_[index];
+  }
+
+  const SegmentedTable& MergedTable::getTable(const std::size_t source) const {
+    assert(source < tables_.size());
+    return tables_[source];
+  }
+}
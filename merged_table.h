@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "record.h"
+#include "segmented_table.h"
+
+namespace dlt {
+  // records of several files ordered by the storage header time
+  // the tables are kept as they are, only the order (file and row of every record) is stored
+  class MergedTable final {
+  public:
+    MergedTable() = default;
+    // k-way merge of the tables. the order of records within a file is kept, so a record which is out of order
+    // (e.g. corrupted one with no time) stays next to its neighbours. equal times are ordered by file
+    explicit MergedTable(std::vector<SegmentedTable>&& tables);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    [[nodiscard]] Record get(std::size_t index) const;
+    // index of the file (in the order passed to the constructor) the record comes from
+    [[nodiscard]] std::size_t getSource(std::size_t index) const;
+
+    [[nodiscard]] const SegmentedTable& getTable(std::size_t source) const;
+
+  private:
+    std::vector<SegmentedTable> tables_;
+    /* order */
+    std::vector<uint32_t> source_;
+    std::vector<std::size_t> row_;
+  };
+}
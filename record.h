@@ -1,36 +1,48 @@
 #pragma once
 #include <memory>
 #include <string_view>
-#include <optional>
-#include <functional>
-
-#include "filereader.h"
+#include <cstdint>
 
 namespace dlt {
-  class Record final {
-    // copy&swap
-    friend void swap(Record& r1, Record& r2);
-    // actual implementation
-    class Impl;
+  class RecordTable;
+  struct record_filter;
+  class MessageCatalog;
+
+  // parsing options shared by all the records of a file
+  struct parse_options {
+    // the payload is formatted by the first getMessage() call. its arguments are walked by length only, so the
+    // record boundaries are the same as of an eager parse
+    // the reader storage is kept alive by such records. ignored by readers without stable storage
+    bool lazy_message = false;
+    // the file is still being written: a record cut by the end of data (or garbage without any record after it
+    // yet) is not reported as corrupted. parsing stops at its beginning, see fs::reader::hold
+    bool hold_tail = false;
+    // records which do not match are skipped right after their headers are read. nullptr keeps everything
+    // corrupted records are always kept: one for a run of corruptions without a stored record in between
+    std::shared_ptr<const record_filter> filter;
+    // non-verbose messages of the ids it knows are decoded by their layouts instead of being printed as [id]
+    std::shared_ptr<const MessageCatalog> catalog;
+  };
 
+  // lightweight view of a single row of RecordTable
+  // it shares ownership of the table, hence it is safe to keep it after the table owner is gone
+  // copying is a reference count increment and moving is free: a record never allocates
+  class Record final {
     using microseconds = uint64_t;
   public:
-    Record();
-    // special case. construct from Impl
-    Record(const Record&) noexcept;
-    Record(Record&&) noexcept;
-    ~Record();
-    
-    // why the fuck we do not do this in the constructor?? because copying not fully-constructed
-    // object will lead to heap corruption despite the fact all the allocations are done before construction
-    // C++ I hate you                                                              just kidding, pls no bugs
-    void parse(fs::reader& reader, std::optional<std::function<void(const Record&)>> parse_except_handler);
+    Record(std::shared_ptr<const RecordTable> table, std::size_t index) noexcept;
+    Record(const Record&) noexcept = default;
+    Record(Record&&) noexcept = default;
+    Record& operator=(const Record&) noexcept = default;
+    Record& operator=(Record&&) noexcept = default;
 
     // not a DLT field. used to flag corrupted message(s)
     [[nodiscard]] bool isCorrupted() const;
     [[nodiscard]] std::string_view getCorruptionCause() const;
     
     [[nodiscard]] const char* getMessage() const;
+    // the same message without strlen. plain string messages point right into the file buffer
+    [[nodiscard]] std::string_view getMessageView() const;
     [[nodiscard]] std::string_view getApid() const;
     [[nodiscard]] std::string_view getCtid() const;
     [[nodiscard]] microseconds getTimeStamp() const;
@@ -42,7 +54,7 @@ namespace dlt {
     [[nodiscard]] std::string_view getEcu() const;
 
   private:
-    /* TODO: (when arrive) std::propagate_const */
-    std::unique_ptr<Impl> pImpl;
+    std::shared_ptr<const RecordTable> table_;
+    std::size_t index_;
   };
 }
@@ -0,0 +1,144 @@
+#include <fstream>
+#include <array>
+#include <cstring>
+
+#include "record_index.h"
+
+namespace dlt::index {
+  namespace {
+    constexpr std::array<char, 8> MAGIC{ 'D', 'L', 'T', 'I', 'D', 'X', '\0', '\0' };
+    // bump on any change of SegmentedTable::save/RecordTable::save layout
+    constexpr uint32_t VERSION = 3;
+    constexpr std::array<char, 8> TIME_MAGIC{ 'D', 'L', 'T', 'T', 'I', 'D', 'X', '\0' };
+    // bump on any change of TimeIndex::save layout
+    constexpr uint32_t TIME_VERSION = 1;
+    constexpr std::array<char, 8> CATALOG_MAGIC{ 'D', 'L', 'T', 'C', 'A', 'T', '\0', '\0' };
+    // bump on any change of MessageCatalog::save layout or of the signals loadFibex supports
+    constexpr uint32_t CATALOG_VERSION = 2;
+
+    struct file_key {
+      uint64_t size;
+      int64_t mtime;
+
+      bool operator==(const file_key& other) const {
+        return size == other.size && mtime == other.mtime;
+      }
+    };
+
+    file_key make_key(const std::filesystem::path& path) {
+      return {
+        static_cast<uint64_t>(std::filesystem::file_size(path)),
+        static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count())
+      };
+    }
+
+    // the dump is written to a temporary file first: a half-written index must never be picked up
+    template <typename Dump>
+    bool write(const std::filesystem::path& path, const std::filesystem::path& index_path,
+      const std::array<char, 8>& magic, const uint32_t version, const Dump& dump) noexcept {
+      try {
+        const auto key = make_key(path);
+        auto temp_path = index_path;
+        temp_path += ".tmp";
+        {
+          std::ofstream os(temp_path, std::ios::binary | std::ios::trunc);
+          os.write(magic.data(), magic.size());
+          os.write(reinterpret_cast<const char*>(&version), sizeof(version));
+          os.write(reinterpret_cast<const char*>(&key.size), sizeof(key.size));
+          os.write(reinterpret_cast<const char*>(&key.mtime), sizeof(key.mtime));
+          dump.save(os);
+          if (!os.flush()) {
+            std::filesystem::remove(temp_path);
+            return false;
+          }
+        }
+        std::filesystem::rename(temp_path, index_path);
+        return true;
+      }
+      catch (...) {
+        return false;
+      }
+    }
+
+    // returns the size of the file the index was written for or nullopt if it is missing or outdated
+    std::optional<uint64_t> open(const std::filesystem::path& path, const std::filesystem::path& index_path,
+      const std::array<char, 8>& expected_magic, const uint32_t expected_version, std::ifstream& is) {
+      std::error_code ec;
+      if (!std::filesystem::exists(index_path, ec)) {
+        return std::nullopt;
+      }
+
+      is.open(index_path, std::ios::binary);
+      std::array<char, 8> magic{};
+      uint32_t version{};
+      file_key key{};
+      is.read(magic.data(), magic.size());
+      is.read(reinterpret_cast<char*>(&version), sizeof(version));
+      is.read(reinterpret_cast<char*>(&key.size), sizeof(key.size));
+      is.read(reinterpret_cast<char*>(&key.mtime), sizeof(key.mtime));
+      if (!is || magic != expected_magic || version != expected_version || !(key == make_key(path))) {
+        return std::nullopt;
+      }
+      return key.size;
+    }
+  }
+
+  std::filesystem::path sidecar(const std::filesystem::path& path) {
+    auto index_path = path;
+    return index_path += ".idx";
+  }
+
+  std::filesystem::path time_sidecar(const std::filesystem::path& path) {
+    auto index_path = path;
+    return index_path += ".tidx";
+  }
+
+  std::filesystem::path catalog_sidecar(const std::filesystem::path& path) {
+    auto index_path = path;
+    return index_path += ".cat";
+  }
+
+  bool save(const std::filesystem::path& path, const SegmentedTable& table) noexcept {
+    return write(path, sidecar(path), MAGIC, VERSION, table);
+  }
+
+  bool save(const std::filesystem::path& path, const TimeIndex& index) noexcept {
+    return write(path, time_sidecar(path), TIME_MAGIC, TIME_VERSION, index);
+  }
+
+  bool save(const std::filesystem::path& path, const MessageCatalog& catalog) noexcept {
+    return write(path, catalog_sidecar(path), CATALOG_MAGIC, CATALOG_VERSION, catalog);
+  }
+
+  std::optional<SegmentedTable> load(const std::filesystem::path& path, fs::reader& reader) {
+    std::ifstream is;
+    const auto size = open(path, sidecar(path), MAGIC, VERSION, is);
+    if (!size || *size != reader.get_len()) {
+      return std::nullopt;
+    }
+
+    SegmentedTable table;
+    if (!table.load(is, reader)) {
+      return std::nullopt;
+    }
+    return table;
+  }
+
+  std::optional<TimeIndex> load_time(const std::filesystem::path& path) {
+    std::ifstream is;
+    TimeIndex index;
+    if (!open(path, time_sidecar(path), TIME_MAGIC, TIME_VERSION, is) || !index.load(is)) {
+      return std::nullopt;
+    }
+    return index;
+  }
+
+  std::optional<MessageCatalog> load_catalog(const std::filesystem::path& path) {
+    std::ifstream is;
+    MessageCatalog catalog;
+    if (!open(path, catalog_sidecar(path), CATALOG_MAGIC, CATALOG_VERSION, is) || !catalog.load(is)) {
+      return std::nullopt;
+    }
+    return catalog;
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <optional>
+#include <filesystem>
+
+#include "segmented_table.h"
+#include "time_index.h"
+#include "catalog.h"
+#include "filereader.h"
+
+// sidecar index (<file>.idx) which allows to reopen already parsed file without parsing it again
+// the index is bound to the size and the modification time of the file and ignored if any of them changes
+// the time index (<file>.tidx) is kept separately: it is tiny and enough to seek without loading all the rows
+// a compiled message catalog is cached next to its FIBEX file (<file>.cat) the same way
+namespace dlt::index {
+  [[nodiscard]]
+  std::filesystem::path sidecar(const std::filesystem::path& path);
+  [[nodiscard]]
+  std::filesystem::path time_sidecar(const std::filesystem::path& path);
+  [[nodiscard]]
+  std::filesystem::path catalog_sidecar(const std::filesystem::path& path);
+
+  // index is optional, hence any failure (e.g. read-only directory) is reported by the return value only
+  bool save(const std::filesystem::path& path, const SegmentedTable& table) noexcept;
+
+  // returns nullopt if there is no valid index for the file
+  // reader must be opened on the same file. loaded rows are decoded lazily and keep the reader storage alive
+  [[nodiscard]]
+  std::optional<SegmentedTable> load(const std::filesystem::path& path, fs::reader& reader);
+
+  bool save(const std::filesystem::path& path, const TimeIndex& index) noexcept;
+
+  [[nodiscard]]
+  std::optional<TimeIndex> load_time(const std::filesystem::path& path);
+
+  // path is of the FIBEX file
+  bool save(const std::filesystem::path& path, const MessageCatalog& catalog) noexcept;
+
+  [[nodiscard]]
+  std::optional<MessageCatalog> load_catalog(const std::filesystem::path& path);
+}
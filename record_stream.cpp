@@ -0,0 +1,31 @@
+#include <cassert>
+
+#include "record_stream.h"
+
+namespace dlt {
+  stream::stream(std::unique_ptr<fs::reader> reader, const std::size_t batch_size, const parse_options& options)
+    : reader_(std::move(reader)), options_(options), batch_size_(batch_size ? batch_size : DEFAULT_BATCH_SIZE) {
+    assert(reader_ != nullptr);
+  }
+
+  std::optional<Record> stream::next() {
+    if ((batch_ == nullptr || cursor_ == batch_->size()) && !fill()) {
+      return std::nullopt;
+    }
+    return std::make_optional<Record>(batch_, cursor_++);
+  }
+
+  bool stream::fill() {
+    batch_ = std::make_shared<RecordTable>();
+    batch_->reserve(batch_size_);
+    cursor_ = 0;
+
+    // a batch never ends with a corrupted record unless eof is reached:
+    // RecordTable::parse returns only after a valid record, so no corrupted duplicates across batches
+    while (!eof_ && batch_->size() < batch_size_) {
+      eof_ = batch_->try_parse(*reader_, options_) == errc::eof;
+    }
+
+    return batch_->size() > 0;
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+#include <optional>
+
+#include "record.h"
+#include "record_table.h"
+#include "filereader.h"
+
+namespace dlt {
+  // pull-based alternative to supervisor: records are parsed on demand in bounded batches
+  // so memory consumption does not depend on the file size
+  class stream {
+  public:
+    static constexpr std::size_t DEFAULT_BATCH_SIZE = 4096;
+
+    explicit stream(std::unique_ptr<fs::reader> reader, std::size_t batch_size = DEFAULT_BATCH_SIZE,
+      const parse_options& options = {});
+
+    // returns std::nullopt once the reader is exhausted
+    [[nodiscard]]
+    std::optional<Record> next();
+
+  private:
+    // parse up to batch_size_ records into a new batch. returns false if nothing was parsed
+    bool fill();
+
+    std::unique_ptr<fs::reader> reader_;
+    parse_options options_;
+    // every batch is a separate table: records handed out keep their batch alive on their own
+    std::shared_ptr<RecordTable> batch_;
+    std::size_t batch_size_;
+    std::size_t cursor_{};
+    bool eof_{false};
+  };
+}
@@ -0,0 +1,811 @@
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <istream>
+#include <ostream>
+
+#include "record_table.h"
+#include "filter.h"
+#include "catalog.h"
+#include "conformance.h"
+#include "argparser.h"
+#include "exceptions.h"
+#include "expected.h"
+
+namespace dlt {
+  namespace {
+    using SubTypeVal = int8_t;
+    constexpr SubTypeVal SUBTYPE_UNKNOWN = -2;
+
+    /* headers of a single record as they are read from the stream. only lives during parsing */
+    struct RecordHeaders {
+      conformance::DltStorageHeader storageHeader{};
+      conformance::DltStandardHeader standardHeader{};
+      conformance::DltStandardHeaderExtra standartHeaderExtra{};
+      conformance::DltExtendedHeader extendedHeader{};
+
+      /* options */
+      bool isBigEndian = false;
+      conformance::Mode mode = conformance::Mode::NonVerbose;
+      conformance::MsgType type = conformance::MsgType::TypeUnknown;
+      SubTypeVal subType = SUBTYPE_UNKNOWN;
+
+      const uint8_t* payload{ nullptr };
+      std::size_t payloadOffset{ 0 };
+      uint16_t payloadLen{ 0 };
+      uint8_t headersLen{ 0 };
+    };
+
+    enum class HeadersStatus {
+      ok,
+      // there is no DLT signature at the current position. the usual case for garbage
+      noSignature,
+      // the data ended in the middle of the record
+      incomplete
+    };
+
+    // nothing in here throws, corruption is the common case for some files and must be cheap
+    [[nodiscard]]
+    HeadersStatus parseHeaders(fs::reader& reader, RecordHeaders& headers) noexcept {
+      using namespace conformance;
+
+      auto& storageHeader = headers.storageHeader;
+      auto& standardHeader = headers.standardHeader;
+      auto& standartHeaderExtra = headers.standartHeaderExtra;
+      auto& extendedHeader = headers.extendedHeader;
+
+      decltype(standardHeader.len) len = 0; /* length of payload + headers (except storage header) */
+      const auto startPos = reader.get_pos();
+
+      /* read helper */
+      auto readData = [&reader, &len](auto& field) {
+#ifdef _BIT_
+#pragma message("use std::bitcast")
+#endif
+        const auto data = reader.try_read(sizeof(field));
+        if (!data) {
+          return false;
+        }
+        ::memcpy(&field, *data, sizeof(field));
+        len += sizeof(field);
+        return true;
+      };
+
+      /* default headers */
+      if (!readData(storageHeader.pattern)) {
+        return HeadersStatus::incomplete;
+      }
+
+      /* verify DLT signature. TODO: verify all fields */
+      if (::memcmp(storageHeader.pattern, DLT_STORAGE_PATTERN.data(), DLT_STORAGE_PATTERN.size()) != 0) {
+        return HeadersStatus::noSignature;
+      }
+
+      // nice order. hopefully this is not endianness-defined
+      if (!readData(storageHeader.seconds) ||
+        !readData(storageHeader.microseconds) ||
+        !readData(storageHeader.ecu) ||
+        !readData(standardHeader)) {
+        return HeadersStatus::incomplete;
+      }
+
+      /* extra flags */
+      const auto htyp = standardHeader.htyp;
+
+      /* endianness */
+      headers.isBigEndian = extractHtyp(htyp, HtypMask::MSBF);
+
+      /* extra fields */
+      if (extractHtyp(htyp, HtypMask::WEID) && !readData(standartHeaderExtra.ecu)) {
+        return HeadersStatus::incomplete;
+      }
+
+
+      // protocol always contains these fields in big endian? it seems so
+      constexpr bool isSwapNeeded = std::endian::native == std::endian::little;
+      if (extractHtyp(htyp, HtypMask::WSID)) {
+        uint8_t buf[sizeof(standartHeaderExtra.seid)];
+        if (!readData(buf)) {
+          return HeadersStatus::incomplete;
+        }
+        standartHeaderExtra.seid = endian::read<decltype(standartHeaderExtra.seid)>(buf, isSwapNeeded);
+      }
+      if (extractHtyp(htyp, HtypMask::WTMS)) {
+        uint8_t buf[sizeof(standartHeaderExtra.tmsp)];
+        if (!readData(buf)) {
+          return HeadersStatus::incomplete;
+        }
+        standartHeaderExtra.tmsp = endian::read<decltype(standartHeaderExtra.tmsp)>(buf, isSwapNeeded);
+      }
+
+      /* extended header */
+      if (extractHtyp(htyp, HtypMask::UEH)) {
+        if (!readData(extendedHeader)) {
+          return HeadersStatus::incomplete;
+        }
+
+        /* message mode, type and subtype */
+        if (extractMsin<MsinMask::VERB>(extendedHeader.msin)) {
+          headers.mode = Mode::Verbose;
+        }
+        headers.type = static_cast<MsgType>(extractMsin<MsinMask::MSTP>(extendedHeader.msin));
+        headers.subType = extractMsin<MsinMask::MTIN>(extendedHeader.msin);
+      }
+
+      len = endian::detail::read16_swap(standardHeader.len, true) - (len - sizeof(DltStorageHeader));
+
+      headers.payloadOffset = reader.get_pos();
+      headers.payloadLen = len;
+      headers.headersLen = static_cast<uint8_t>(headers.payloadOffset - startPos);
+      const auto payload = reader.try_read(len);
+      if (!payload) {
+        return HeadersStatus::incomplete;
+      }
+      headers.payload = reinterpret_cast<const uint8_t*>(*payload);
+
+      /* TODO: put some safety size checks here (and endianness swaps) */
+      return HeadersStatus::ok;
+    }
+
+    // the message replaces the content of the buffer which keeps its capacity
+    void assembleMessage(const conformance::MsgType type, const SubTypeVal subType, const bool isVerbose,
+      const bool isBigEndian, const uint8_t noar, const uint8_t* payload_, const std::size_t payloadLen,
+      const MessageCatalog* catalog, std::string& message) {
+      using namespace conformance;
+      const auto end = payload_ + payloadLen;
+      // payload may be the last bytes of a mapping, nothing past it must be touched
+      const auto require = [&payload_, end](const std::size_t bytes) {
+        if (static_cast<std::size_t>(end - payload_) < bytes) {
+          throw except::parse_exception("argument exceeds payload");
+        }
+      };
+      message.clear();
+      if (type == MsgType::TypeControl) {
+        if (isVerbose) {
+          throw except::parse_exception("no support for verbose ctrl messages. is it required?");
+        }
+
+        require(sizeof(CtrlServiceId));
+        const auto ctrlServiceId = endian::extract<CtrlServiceId>(payload_, isBigEndian);
+
+        if (static_cast<ControlType>(subType) == ControlType::ControlResponse) {
+          require(sizeof(CtrlReturnType));
+          const auto ctrlReturnType = endian::extract<CtrlReturnType>(payload_);
+
+          if (ctrlServiceId == CtrlServiceId::MARKER) {
+            message = "MARKER";
+          }
+          else {
+            message += '[';
+            message += getCtrlServiceIdName(ctrlServiceId);
+            message += ' ';
+            message += getCtrlReturnTypeName(ctrlReturnType);
+            message += "] ";
+
+            switch (ctrlServiceId) {
+            case CtrlServiceId::GET_SOFTWARE_VERSION:
+            {
+              require(sizeof(uint32_t));
+              const auto len = endian::extract<uint32_t>(payload_);
+              require(len);
+              std::copy(payload_, payload_ + len, std::back_inserter(message));
+              break;
+            }
+            case CtrlServiceId::CONNECTION_INFO:
+            {
+              require(sizeof(ConnectionStatus) + DLT_ID_SIZE);
+              const auto status = endian::extract<ConnectionStatus>(payload_);
+              message += getConnectionStatus(status);
+              message += ' ';
+              std::copy(payload_, payload_ + DLT_ID_SIZE, std::back_inserter(message));
+              break;
+            }
+            case CtrlServiceId::TIMEZONE:
+            {
+              require(sizeof(uint32_t) + sizeof(bool));
+              const auto timezone = endian::extract<uint32_t>(payload_);
+              message = std::to_string(timezone);
+              const auto isDst = endian::extract<bool>(payload_);
+              if (isDst) {
+                message += "DST";
+              }
+            }
+            default:
+              break; /* no additional data in payload */
+            }
+          }
+        }
+        else {
+          message += '[';
+          message += getCtrlServiceIdName(ctrlServiceId);
+          message += ']';
+        }
+      }
+      else if (isVerbose) {
+        if (noar > 0) {
+          if (isBigEndian) {
+            ArgParser<true>(payload_, end, noar, message);
+          }
+          else {
+            ArgParser<false>(payload_, end, noar, message);
+          }
+        }
+      }
+      else {
+        /* non-verbose by default */
+        require(sizeof(uint32_t));
+        const auto id = endian::extract<uint32_t>(payload_, isBigEndian);
+        if (catalog == nullptr || !catalog->format(id, payload_, end, isBigEndian, message)) {
+          message += '[';
+          message += std::to_string(id);
+          message += ']';
+        }
+      }
+    }
+
+    // whether assembleMessage accepts the payload. verbose and catalog arguments are walked without formatting
+    [[nodiscard]]
+    bool isWellFormed(const conformance::MsgType type, const SubTypeVal subType, const bool isVerbose,
+      const bool isBigEndian, const uint8_t noar, const uint8_t* payload, const std::size_t payloadLen,
+      const MessageCatalog* catalog, std::string& scratch) {
+      using namespace conformance;
+      const auto end = payload + payloadLen;
+      if (type == MsgType::TypeControl) {
+        // control messages are rare enough to be checked by formatting
+        try {
+          assembleMessage(type, subType, isVerbose, isBigEndian, noar, payload, payloadLen, catalog, scratch);
+          return true;
+        }
+        catch (const except::parse_exception&) {
+          return false;
+        }
+      }
+      if (isVerbose) {
+        return noar == 0 || (isBigEndian ? ArgParser<true>::skip(payload, end, noar)
+          : ArgParser<false>::skip(payload, end, noar)) != nullptr;
+      }
+      if (payloadLen < sizeof(uint32_t)) {
+        return false;
+      }
+      return catalog == nullptr || catalog->isWellFormed(endian::read<uint32_t>(payload, isBigEndian),
+        payload + sizeof(uint32_t), end, isBigEndian);
+    }
+
+    // the message of a verbose log with the only ascii string argument is the string itself
+    // it is null-terminated right in the payload, so there is nothing to format. empty view without data if there is
+    std::string_view findPlainString(const conformance::MsgType type, const bool isVerbose, const bool isBigEndian,
+      const uint8_t noar, const uint8_t* payload, const std::size_t payloadLen) noexcept {
+      using namespace conformance;
+      using namespace detail;
+      constexpr auto STRING_OFFSET = sizeof(ArgType) + sizeof(uint16_t);
+
+      if (type == MsgType::TypeControl || !isVerbose || noar != 1 || payloadLen <= STRING_OFFSET) {
+        return {};
+      }
+
+      // the same checks as ArgParser does. anything unusual is left to it, including error reporting
+      const auto argType = static_cast<ArgType>(endian::read<uint32_t>(payload, isBigEndian));
+      if (!(argType & ArgType::INFO_STRG) || argType & ArgType::INFO_VARI || (argType & ArgCodingMask) != CodingType::SCOD_ASCII) {
+        return {};
+      }
+      const auto len = endian::read<uint16_t>(payload + sizeof(ArgType), isBigEndian);
+      if (len == 0 || STRING_OFFSET + len > payloadLen || payload[STRING_OFFSET + len - 1] != '\0') {
+        return {};
+      }
+      return { reinterpret_cast<const char*>(payload + STRING_OFFSET), static_cast<std::size_t>(len - 1) };
+    }
+
+    template <typename T>
+    void writeRaw(std::ostream& os, const T* data, const std::size_t count) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+
+    template <typename T>
+    bool readRaw(std::istream& is, T* data, const std::size_t count) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      return static_cast<bool>(is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+
+    template <typename T>
+    void writeColumn(std::ostream& os, const std::vector<T>& column, const std::size_t from = 0) {
+      writeRaw(os, column.data() + from, column.size() - from);
+    }
+
+    template <typename T>
+    bool readColumn(std::istream& is, std::vector<T>& column, const std::size_t size) {
+      column.resize(size);
+      return readRaw(is, column.data(), size);
+    }
+
+    filter_fields filterFields(const RecordHeaders& headers, const uint64_t timestamp) {
+      filter_fields fields;
+      ::memcpy(&fields.ecu, headers.storageHeader.ecu, sizeof(fields.ecu));
+      ::memcpy(&fields.apid, headers.extendedHeader.apid, sizeof(fields.apid));
+      ::memcpy(&fields.ctid, headers.extendedHeader.ctid, sizeof(fields.ctid));
+      fields.type = static_cast<int8_t>(headers.type);
+      fields.subType = headers.subType;
+      fields.time = timestamp;
+      return fields;
+    }
+
+    std::string_view getView(const std::array<char, 4>& field) {
+      const size_t len = field[3] ? 4 : field[2] ? 3 : field[1] ? 2 : field[0] ? 1 : 0;
+      return { field.data(), len };
+    }
+  }
+
+  namespace detail {
+    std::string_view string_arena::store(const std::string_view str) {
+      const auto size = str.size() + 1;
+      if (size > left_) {
+        // oversized strings get their own block, the current one is kept for the next ones
+        const auto block_size = std::max(size, BLOCK_SIZE);
+        auto& block = blocks_.emplace_back(new char[block_size]);
+        if (block_size != BLOCK_SIZE) {
+          std::copy(str.cbegin(), str.cend(), block.get());
+          block[str.size()] = '\0';
+          return { block.get(), str.size() };
+        }
+        cursor_ = block.get();
+        left_ = block_size;
+      }
+
+      const auto entry = cursor_;
+      std::copy(str.cbegin(), str.cend(), entry);
+      entry[str.size()] = '\0';
+      cursor_ += size;
+      left_ -= size;
+      return { entry, str.size() };
+    }
+  }
+
+  RecordTable::RecordTable() {
+    // empty id must be 0
+    static_cast<void>(intern({ 0, 0, 0, 0 }));
+  }
+
+  RecordTable::id_t RecordTable::intern(const uint8_t (&id)[4]) {
+    uint32_t key;
+    ::memcpy(&key, id, sizeof(key));
+
+    const auto [it, inserted] = idsIndex_.try_emplace(key, static_cast<id_t>(ids_.size()));
+    if (inserted) {
+      auto& value = ids_.emplace_back();
+      ::memcpy(value.data(), id, sizeof(key));
+    }
+    return it->second;
+  }
+
+  void RecordTable::appendCorrupted(const std::string_view cause, const std::size_t offset) {
+    timestamp_.push_back(0);
+    timestampExtra_.push_back(0);
+    sessionId_.push_back(0);
+    counter_.push_back(0);
+    type_.push_back(static_cast<int8_t>(conformance::MsgType::TypeUnknown));
+    subType_.push_back(SUBTYPE_UNKNOWN);
+    noar_.push_back(0);
+    apid_.push_back(0);
+    ctid_.push_back(0);
+    ecu_.push_back(0);
+    payload_.push_back(nullptr);
+    payloadOffset_.push_back(offset);
+    payloadLen_.push_back(0);
+    headersLen_.push_back(0);
+    flags_.push_back(CORRUPTED | MESSAGE_READY);
+    message_.push_back(arena_.store(cause));
+  }
+
+  void RecordTable::parse(fs::reader& reader, const parse_options& options) {
+    if (try_parse(reader, options) == errc::eof) {
+      throw except::eof{};
+    }
+  }
+
+  errc RecordTable::try_parse(fs::reader& reader, const parse_options& options) {
+    // if parse exception occured push corrupted record if no others in a row
+    // this is to be in compliance with DLT viewer
+    const auto markCorrupted = [this](const std::string_view cause, const std::size_t offset) {
+      if (size() == 0 || !isCorrupted(size() - 1)) {
+        appendCorrupted(cause, offset);
+      }
+    };
+
+    while (true) {
+      // nothing left to parse. the previous record ended exactly at the end of the file
+      if (reader.is_eof()) {
+        return errc::eof;
+      }
+
+      const auto current_pos = reader.get_pos();
+
+      RecordHeaders headers;
+      const auto status = parseHeaders(reader, headers);
+      if (status == HeadersStatus::incomplete) {
+        if (options.hold_tail) {
+          reader.hold(current_pos);
+          return errc::eof;
+        }
+        markCorrupted("file ended with incomplete record", current_pos);
+        return errc::eof;
+      }
+      if (status == HeadersStatus::noSignature) {
+        // nothing but the next storage header may start a record. jump straight to it
+        if (!reader.resync(conformance::DLT_STORAGE_PATTERN, current_pos + 1) && options.hold_tail) {
+          reader.hold(current_pos);
+          return errc::eof;
+        }
+        markCorrupted("invalid DLT signature", current_pos);
+        continue;
+      }
+
+      const auto& storageHeader = headers.storageHeader;
+      const auto timestamp = static_cast<microseconds>(storageHeader.seconds) * 1'000'000 + storageHeader.microseconds;
+      const auto skip = [this, &reader, current_pos]() {
+        // keep the boundary now and then for the stitching of chunks
+        const auto last = std::max<std::size_t>(skipped_.empty() ? 0 : skipped_.back(), size() == 0 ? 0 : getOffset(size() - 1));
+        if ((skipped_.empty() && size() == 0) || current_pos >= last + SYNC_INTERVAL) {
+          skipped_.push_back(current_pos);
+        }
+        reader.notify_success(current_pos);
+        DLT_STATS(++stats_.filtered);
+        return errc::filtered;
+      };
+
+      const bool isVerbose = headers.mode == conformance::Mode::Verbose;
+      const auto noar = headers.extendedHeader.noar;
+
+      // a record is only passed by its length if formatting would accept the payload as well, otherwise a
+      // filtered or lazy parse would resync elsewhere than a full one does
+      const auto wellFormed = [this, &headers, &options, isVerbose, noar]() {
+        return isWellFormed(headers.type, headers.subType, isVerbose, headers.isBigEndian, noar, headers.payload,
+          headers.payloadLen, options.catalog.get(), scratch_);
+      };
+
+      // the payload is not formatted unless the text is searched. an ill-formed one is formatted to report it
+      const auto filter = options.filter.get();
+      const bool rejected = filter != nullptr && (!filter->matches(filterFields(headers, timestamp))
+        || !filter->mayContain(headers.payload, headers.payloadLen, isVerbose));
+      if (rejected && wellFormed()) {
+        return skip();
+      }
+      const bool searched = filter != nullptr && !filter->text.empty();
+
+      uint8_t flags = (headers.isBigEndian ? MSB_FIRST : 0) | (isVerbose ? VERBOSE : 0);
+      std::string_view message;
+      const auto plainString = findPlainString(headers.type, isVerbose, headers.isBigEndian, noar, headers.payload,
+        headers.payloadLen);
+      // nothing may point into the buffers of a reader without stable storage: such records are formatted eagerly
+      const bool pinned = storage_ != nullptr || (storage_ = reader.get_storage()) != nullptr;
+      const bool lazy = options.lazy_message && pinned && !searched;
+      if (lazy && catalog_ != options.catalog) {
+        // lazy messages are decoded by the catalog of the parse
+        catalog_ = options.catalog;
+      }
+      if (plainString.data() != nullptr && pinned) {
+        if (searched && plainString.find(filter->text) == std::string_view::npos) {
+          return skip();
+        }
+        // the message is a view into the reader's buffer which is kept alive by the table
+        message = plainString;
+        flags |= MESSAGE_READY;
+      }
+      else if (lazy && !rejected && wellFormed()) {
+        // the payload is formatted on demand
+      }
+      else {
+        // ill-formed payload is rare enough to be reported by formatters via exceptions
+        try {
+          DLT_STATS(const scoped_timer timer(stats_.format));
+          assembleMessage(headers.type, headers.subType, isVerbose, headers.isBigEndian, noar, headers.payload,
+            headers.payloadLen, options.catalog.get(), scratch_);
+        }
+        catch (const except::parse_exception& e) {
+          // ill-formed; continue parsing from the next storage header after pos
+          // every position in between would fail the signature check anyway, so nothing is lost
+          if (!reader.resync(conformance::DLT_STORAGE_PATTERN, current_pos + 1) && options.hold_tail) {
+            reader.hold(current_pos);
+            return errc::eof;
+          }
+          markCorrupted(e.what(), current_pos);
+          continue;
+        }
+        if (rejected || (searched && scratch_.find(filter->text) == std::string::npos)) {
+          return skip();
+        }
+        message = arena_.store(scratch_);
+        flags |= MESSAGE_READY;
+      }
+
+      reader.notify_success(current_pos);
+
+      timestamp_.push_back(timestamp);
+      timestampExtra_.push_back(headers.standartHeaderExtra.tmsp);
+      sessionId_.push_back(headers.standartHeaderExtra.seid);
+      counter_.push_back(headers.standardHeader.mcnt);
+      type_.push_back(static_cast<int8_t>(headers.type));
+      subType_.push_back(headers.subType);
+      noar_.push_back(noar);
+      apid_.push_back(intern(headers.extendedHeader.apid));
+      ctid_.push_back(intern(headers.extendedHeader.ctid));
+      ecu_.push_back(intern(storageHeader.ecu));
+      payload_.push_back(lazy ? headers.payload : nullptr);
+      payloadOffset_.push_back(headers.payloadOffset);
+      payloadLen_.push_back(headers.payloadLen);
+      headersLen_.push_back(headers.headersLen);
+      flags_.push_back(flags);
+      message_.push_back(message);
+      return errc::ok;
+    }
+  }
+
+  void RecordTable::save(std::ostream& os, const std::size_t from) const {
+    assert(from <= size());
+    const uint64_t rows = size() - from;
+    const uint64_t ids = ids_.size();
+    writeRaw(os, &rows, 1);
+    writeRaw(os, &ids, 1);
+    writeColumn(os, ids_);
+
+    writeColumn(os, timestamp_, from);
+    writeColumn(os, timestampExtra_, from);
+    writeColumn(os, sessionId_, from);
+    writeColumn(os, counter_, from);
+    writeColumn(os, type_, from);
+    writeColumn(os, subType_, from);
+    writeColumn(os, noar_, from);
+    writeColumn(os, apid_, from);
+    writeColumn(os, ctid_, from);
+    writeColumn(os, ecu_, from);
+    writeColumn(os, payloadOffset_, from);
+    writeColumn(os, payloadLen_, from);
+    writeColumn(os, headersLen_, from);
+
+    // the only state which is not bound to the file: formatted messages are not stored
+    std::vector<uint8_t> flags(flags_.size() - from);
+    std::transform(flags_.cbegin() + from, flags_.cend(), flags.begin(), [](const uint8_t flag) {
+      return static_cast<uint8_t>(flag & CORRUPTED ? flag : flag & ~MESSAGE_READY);
+    });
+    writeColumn(os, flags);
+
+    // corruption causes in order of corrupted rows
+    for (std::size_t i = from; i != size(); ++i) {
+      if (isCorrupted(i)) {
+        const uint32_t len = static_cast<uint32_t>(message_[i].size());
+        writeRaw(os, &len, 1);
+        writeRaw(os, message_[i].data(), len);
+      }
+    }
+  }
+
+  bool RecordTable::load(std::istream& is, fs::reader& reader) {
+    assert(size() == 0 && "index may only be loaded into an empty table");
+
+    uint64_t rows{};
+    uint64_t ids{};
+    if (!readRaw(is, &rows, 1) || !readRaw(is, &ids, 1) || ids == 0 || !readColumn(is, ids_, ids)) {
+      return false;
+    }
+    idsIndex_.clear();
+    for (id_t i = 0; i != ids_.size(); ++i) {
+      uint32_t key;
+      ::memcpy(&key, ids_[i].data(), sizeof(key));
+      idsIndex_.emplace(key, i);
+    }
+
+    if (!readColumn(is, timestamp_, rows) ||
+      !readColumn(is, timestampExtra_, rows) ||
+      !readColumn(is, sessionId_, rows) ||
+      !readColumn(is, counter_, rows) ||
+      !readColumn(is, type_, rows) ||
+      !readColumn(is, subType_, rows) ||
+      !readColumn(is, noar_, rows) ||
+      !readColumn(is, apid_, rows) ||
+      !readColumn(is, ctid_, rows) ||
+      !readColumn(is, ecu_, rows) ||
+      !readColumn(is, payloadOffset_, rows) ||
+      !readColumn(is, payloadLen_, rows) ||
+      !readColumn(is, headersLen_, rows) ||
+      !readColumn(is, flags_, rows)) {
+      return false;
+    }
+
+    const auto validId = [&ids](const id_t id) { return id < ids; };
+    if (!std::all_of(apid_.cbegin(), apid_.cend(), validId) ||
+      !std::all_of(ctid_.cbegin(), ctid_.cend(), validId) ||
+      !std::all_of(ecu_.cbegin(), ecu_.cend(), validId)) {
+      return false;
+    }
+
+    payload_.assign(rows, nullptr);
+    message_.assign(rows, {});
+    std::string cause;
+    for (std::size_t i = 0; i != rows; ++i) {
+      if (isCorrupted(i)) {
+        uint32_t len{};
+        if (!readRaw(is, &len, 1)) {
+          return false;
+        }
+        cause.resize(len);
+        if (!readRaw(is, cause.data(), len)) {
+          return false;
+        }
+        message_[i] = arena_.store(cause);
+        continue;
+      }
+
+      // empty payload has no pointer to resolve (and may even be located at the very end of the file)
+      if (payloadLen_[i] == 0) {
+        message_[i] = arena_.store({});
+        flags_[i] |= MESSAGE_READY;
+        continue;
+      }
+
+      if (payloadOffset_[i] >= reader.get_len()) {
+        return false;
+      }
+      reader.set_pos(payloadOffset_[i]);
+      const auto payload = reader.try_read(payloadLen_[i]);
+      if (!payload) {
+        return false;
+      }
+      payload_[i] = reinterpret_cast<const uint8_t*>(*payload);
+    }
+
+    storage_ = reader.get_storage();
+    return true;
+  }
+
+  std::size_t RecordTable::size() const noexcept {
+    return flags_.size();
+  }
+
+  void RecordTable::reserve(const std::size_t size) {
+    timestamp_.reserve(size);
+    timestampExtra_.reserve(size);
+    sessionId_.reserve(size);
+    counter_.reserve(size);
+    type_.reserve(size);
+    subType_.reserve(size);
+    noar_.reserve(size);
+    apid_.reserve(size);
+    ctid_.reserve(size);
+    ecu_.reserve(size);
+    payload_.reserve(size);
+    payloadOffset_.reserve(size);
+    payloadLen_.reserve(size);
+    headersLen_.reserve(size);
+    flags_.reserve(size);
+    message_.reserve(size);
+  }
+
+  std::size_t RecordTable::getOffset(const std::size_t index) const {
+    return payloadOffset_[index] - headersLen_[index];
+  }
+
+  std::size_t RecordTable::lowerBound(const std::size_t offset) const {
+    // rows are always ordered by offset
+    std::size_t first = 0;
+    std::size_t count = size();
+    while (count > 0) {
+      const auto step = count / 2;
+      if (getOffset(first + step) < offset) {
+        first += step + 1;
+        count -= step + 1;
+      }
+      else {
+        count = step;
+      }
+    }
+    return first;
+  }
+
+  bool RecordTable::isSyncPoint(const std::size_t offset) const {
+    const auto row = lowerBound(offset);
+    return (row < size() && getOffset(row) == offset) || std::binary_search(skipped_.cbegin(), skipped_.cend(), offset);
+  }
+
+  const table_stats& RecordTable::getStats() const noexcept {
+    return stats_;
+  }
+
+  bool RecordTable::isCorrupted(const std::size_t index) const {
+    return flags_[index] & CORRUPTED;
+  }
+
+  std::string_view RecordTable::getCorruptionCause(const std::size_t index) const {
+    if (!isCorrupted(index)) {
+      throw std::logic_error("record is not corrupted");
+    }
+    return message_[index];
+  }
+
+  std::string_view RecordTable::getMessage(const std::size_t index) const {
+    const auto flags = flags_[index];
+    if (flags & CORRUPTED) {
+      return {};
+    }
+
+    if (!(flags & MESSAGE_READY)) {
+      // payload of lazy records is always backed by storage_
+      const auto plainString = findPlainString(static_cast<conformance::MsgType>(type_[index]), flags & VERBOSE,
+        flags & MSB_FIRST, noar_[index], payload_[index], payloadLen_[index]);
+      if (plainString.data() != nullptr) {
+        message_[index] = plainString;
+        flags_[index] |= MESSAGE_READY;
+        return message_[index];
+      }
+
+      try {
+        assembleMessage(static_cast<conformance::MsgType>(type_[index]), subType_[index], flags & VERBOSE,
+          flags & MSB_FIRST, noar_[index], payload_[index], payloadLen_[index], catalog_.get(), scratch_);
+      }
+      catch (const except::parse_exception& e) {
+        // too late to resync, the record boundaries are already known to be valid
+        scratch_.assign("[corrupted payload: ").append(e.what()).append("]");
+      }
+      message_[index] = arena_.store(scratch_);
+      flags_[index] |= MESSAGE_READY;
+    }
+
+    return message_[index];
+  }
+
+  std::string_view RecordTable::getApid(const std::size_t index) const {
+    return getView(ids_[apid_[index]]);
+  }
+
+  std::string_view RecordTable::getCtid(const std::size_t index) const {
+    return getView(ids_[ctid_[index]]);
+  }
+
+  std::string_view RecordTable::getEcu(const std::size_t index) const {
+    return getView(ids_[ecu_[index]]);
+  }
+
+  RecordTable::microseconds RecordTable::getTimeStamp(const std::size_t index) const {
+    return timestamp_[index];
+  }
+
+  uint32_t RecordTable::getTimestampExtra(const std::size_t index) const {
+    return timestampExtra_[index];
+  }
+
+  uint32_t RecordTable::getSessionId(const std::size_t index) const {
+    return sessionId_[index];
+  }
+
+  uint8_t RecordTable::getMessageCounter(const std::size_t index) const {
+    return counter_[index];
+  }
+
+  int8_t RecordTable::getType(const std::size_t index) const {
+    return type_[index];
+  }
+
+  int8_t RecordTable::getSubType(const std::size_t index) const {
+    return subType_[index];
+  }
+
+  RecordTable::id_t RecordTable::getApidKey(const std::size_t index) const {
+    return apid_[index];
+  }
+
+  RecordTable::id_t RecordTable::getCtidKey(const std::size_t index) const {
+    return ctid_[index];
+  }
+
+  RecordTable::id_t RecordTable::getEcuKey(const std::size_t index) const {
+    return ecu_[index];
+  }
+
+  std::string_view RecordTable::getId(const id_t key) const {
+    return getView(ids_[key]);
+  }
+
+  std::size_t RecordTable::idsNum() const noexcept {
+    return ids_.size();
+  }
+}
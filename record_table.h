@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <array>
+#include <iosfwd>
+
+#include "record.h"
+#include "filereader.h"
+#include "expected.h"
+#include "stats.h"
+
+namespace dlt {
+  namespace detail {
+    // append-only storage for strings. blocks are never reallocated, hence stored views stay valid
+    class string_arena final {
+    public:
+      static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+      // stores str followed by null-character, so data() of the result may be used as c-string
+      std::string_view store(std::string_view str);
+
+    private:
+      std::vector<std::unique_ptr<char[]>> blocks_;
+      char* cursor_{ nullptr };
+      std::size_t left_{ 0 };
+    };
+  }
+
+  // columnar storage of parsed records. Record is a lightweight view over a row of this table
+  // every column is a contiguous array, DLT ids (apid/ctid/ecu) are interned per table
+  class RecordTable final {
+  public:
+    using microseconds = uint64_t;
+    using id_t = uint32_t;
+
+    RecordTable();
+    RecordTable(RecordTable&&) noexcept = default;
+    RecordTable& operator=(RecordTable&&) noexcept = default;
+
+    // parse the next record from the reader and append it
+    // if the stream is ill-formed a corrupted record is appended before it (only one in a row to conform to DLT viewer)
+    // throws except::eof once the reader is exhausted
+    void parse(fs::reader& reader, const parse_options& options);
+
+    // the same as parse but reports the end of data with errc::eof instead of throwing
+    // and a record skipped by the filter with errc::filtered
+    [[nodiscard]]
+    errc try_parse(fs::reader& reader, const parse_options& options);
+
+    // binary dump of all the columns of rows [from, size()) but formatted messages. used by the sidecar index
+    void save(std::ostream& os, std::size_t from = 0) const;
+    // restore the dump. rows are decoded lazily from the reader which must be opened on the same file
+    // returns false if the dump is broken or does not match the reader
+    [[nodiscard]] bool load(std::istream& is, fs::reader& reader);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+    void reserve(std::size_t size);
+
+    // position of the record in the file. for corrupted ones this is where the corruption was detected
+    [[nodiscard]] std::size_t getOffset(std::size_t index) const;
+    // index of the first row located at or after offset
+    [[nodiscard]] std::size_t lowerBound(std::size_t offset) const;
+    // whether parsing of this table passed a record boundary at offset: either a row starts there or a skipped
+    // (filtered) record which was remembered. a parse which meets this table there continues exactly as it did
+    [[nodiscard]] bool isSyncPoint(std::size_t offset) const;
+    // gathered by try_parse into this table (DLT_WITH_STATS only)
+    [[nodiscard]] const table_stats& getStats() const noexcept;
+
+    // row accessors. lazy messages are formatted and cached by getMessage (not thread-safe)
+    [[nodiscard]] bool isCorrupted(std::size_t index) const;
+    [[nodiscard]] std::string_view getCorruptionCause(std::size_t index) const;
+    [[nodiscard]] std::string_view getMessage(std::size_t index) const;
+    [[nodiscard]] std::string_view getApid(std::size_t index) const;
+    [[nodiscard]] std::string_view getCtid(std::size_t index) const;
+    [[nodiscard]] std::string_view getEcu(std::size_t index) const;
+    [[nodiscard]] microseconds getTimeStamp(std::size_t index) const;
+    [[nodiscard]] uint32_t getTimestampExtra(std::size_t index) const;
+    [[nodiscard]] uint32_t getSessionId(std::size_t index) const;
+    [[nodiscard]] uint8_t getMessageCounter(std::size_t index) const;
+    [[nodiscard]] int8_t getType(std::size_t index) const;
+    [[nodiscard]] int8_t getSubType(std::size_t index) const;
+
+    // ids are interned per table: rows with the same id have the same key. keys are below idsNum()
+    [[nodiscard]] id_t getApidKey(std::size_t index) const;
+    [[nodiscard]] id_t getCtidKey(std::size_t index) const;
+    [[nodiscard]] id_t getEcuKey(std::size_t index) const;
+    [[nodiscard]] std::string_view getId(id_t key) const;
+    [[nodiscard]] std::size_t idsNum() const noexcept;
+
+  private:
+    /* row flags */
+    enum Flags : uint8_t {
+      CORRUPTED = 0x01,
+      MSB_FIRST = 0x02,
+      VERBOSE = 0x04,
+      /* message_ column is valid (either parsed eagerly or already evaluated) */
+      MESSAGE_READY = 0x08
+    };
+
+    // id 0 is always the empty one
+    id_t intern(const uint8_t (&id)[4]);
+    void appendCorrupted(std::string_view cause, std::size_t offset);
+
+    /* columns */
+    std::vector<microseconds> timestamp_;
+    std::vector<uint32_t> timestampExtra_;
+    std::vector<uint32_t> sessionId_;
+    std::vector<uint8_t> counter_;
+    std::vector<int8_t> type_;
+    std::vector<int8_t> subType_;
+    std::vector<uint8_t> noar_;
+    std::vector<id_t> apid_;
+    std::vector<id_t> ctid_;
+    std::vector<id_t> ecu_;
+    // payload of lazy records, nullptr otherwise
+    std::vector<const uint8_t*> payload_;
+    // position of the payload in the file (where the corruption was detected for corrupted records)
+    std::vector<uint64_t> payloadOffset_;
+    std::vector<uint16_t> payloadLen_;
+    std::vector<uint8_t> headersLen_;
+
+    // lazy evaluation state is the only thing which changes after parsing
+    mutable std::vector<uint8_t> flags_;
+    // formatted message or corruption cause for corrupted records
+    // messages which are a plain string argument point into the payload instead of the arena
+    mutable std::vector<std::string_view> message_;
+    mutable detail::string_arena arena_;
+    // messages are formatted here and then copied to the arena: no allocation per message
+    mutable std::string scratch_;
+
+    /* interned DLT ids */
+    std::vector<std::array<char, 4>> ids_;
+    std::unordered_map<uint32_t, id_t> idsIndex_;
+
+    // offsets of filtered records, at most one per SYNC_INTERVAL bytes of the file without rows
+    // so a chunk reparsed from another position finds where it meets this table without reparsing much
+    static constexpr std::size_t SYNC_INTERVAL = 64 * 1024;
+    std::vector<uint64_t> skipped_;
+    table_stats stats_;
+
+    // keeps payload of lazy records and in-place messages alive
+    std::shared_ptr<const void> storage_;
+    // decodes non-verbose lazy records, see parse_options::catalog
+    std::shared_ptr<const MessageCatalog> catalog_;
+  };
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define DLT_SEARCH_SSE2
+#endif
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+namespace dlt::search {
+  namespace detail {
+    inline unsigned lowest_bit(const unsigned mask) noexcept {
+#ifdef _MSC_VER
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return index;
+#else
+      return __builtin_ctz(mask);
+#endif
+    }
+
+    /* scalar fallback: memchr for the first byte is vectorized by any sane libc */
+    inline std::size_t find_scalar(const char* data, const std::size_t len, const std::string_view needle,
+      std::size_t from) noexcept {
+      const auto last = len - needle.size();
+      while (from <= last) {
+        const auto candidate = static_cast<const char*>(::memchr(data + from, needle[0], last - from + 1));
+        if (candidate == nullptr) {
+          break;
+        }
+        from = candidate - data;
+        if (::memcmp(candidate + 1, needle.data() + 1, needle.size() - 1) == 0) {
+          return from;
+        }
+        ++from;
+      }
+      return len;
+    }
+  }
+
+  // offset of the first occurrence of needle in [data + from, data + len) or len if there is none
+  // compares first and last bytes of the needle for 16 positions at once and verifies candidates only
+  inline std::size_t find(const char* data, const std::size_t len, const std::string_view needle,
+    std::size_t from) noexcept {
+    if (needle.empty()) {
+      return from < len ? from : len;
+    }
+    if (needle.size() > len || from > len - needle.size()) {
+      return len;
+    }
+
+#ifdef DLT_SEARCH_SSE2
+    const auto first = _mm_set1_epi8(needle.front());
+    const auto last = _mm_set1_epi8(needle.back());
+    const auto tail = needle.size() - 1;
+
+    for (; from + tail + 16 <= len; from += 16) {
+      const auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+      const auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from + tail));
+      auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+
+      while (mask != 0) {
+        const auto offset = from + detail::lowest_bit(mask);
+        if (tail < 2 || ::memcmp(data + offset + 1, needle.data() + 1, tail - 1) == 0) {
+          return offset;
+        }
+        mask &= mask - 1;
+      }
+    }
+#endif
+
+    return detail::find_scalar(data, len, needle, from);
+  }
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <ostream>
+
+#include "segmented_table.h"
+
+namespace dlt {
+  void SegmentedTable::append(std::shared_ptr<const RecordTable> table, const std::size_t from) {
+    assert(table != nullptr && from <= table->size());
+    if (from == table->size()) {
+      return;
+    }
+    ends_.push_back(size() + table->size() - from);
+    lastCorrupted_ = table->isCorrupted(table->size() - 1);
+    segments_.push_back({ std::move(table), from });
+  }
+
+  void SegmentedTable::splice(std::shared_ptr<const RecordTable> table, std::size_t from) {
+    assert(table != nullptr && from <= table->size());
+    if (from < table->size() && size() != 0 && table->isCorrupted(from)) {
+      from += lastCorrupted_;
+    }
+    append(std::move(table), from);
+  }
+
+  std::size_t SegmentedTable::size() const noexcept {
+    return ends_.empty() ? 0 : ends_.back();
+  }
+
+  std::size_t SegmentedTable::find(const std::size_t index) const {
+    assert(index < size());
+    return std::upper_bound(ends_.cbegin(), ends_.cend(), index) - ends_.cbegin();
+  }
+
+  std::pair<const RecordTable&, std::size_t> SegmentedTable::locate(const std::size_t index) const {
+    const auto i = find(index);
+    const auto begin = i == 0 ? 0 : ends_[i - 1];
+    return { *segments_[i].table, segments_[i].from + index - begin };
+  }
+
+  Record SegmentedTable::get(const std::size_t index) const {
+    const auto i = find(index);
+    const auto begin = i == 0 ? 0 : ends_[i - 1];
+    return Record(segments_[i].table, segments_[i].from + index - begin);
+  }
+
+  void SegmentedTable::save(std::ostream& os) const {
+    const uint64_t segments = segments_.size();
+    os.write(reinterpret_cast<const char*>(&segments), sizeof(segments));
+    for (const auto& segment : segments_) {
+      segment.table->save(os, segment.from);
+    }
+  }
+
+  bool SegmentedTable::load(std::istream& is, fs::reader& reader) {
+    assert(size() == 0 && "index may only be loaded into an empty table");
+
+    uint64_t segments{};
+    if (!is.read(reinterpret_cast<char*>(&segments), sizeof(segments))) {
+      return false;
+    }
+    for (uint64_t i = 0; i != segments; ++i) {
+      auto table = std::make_shared<RecordTable>();
+      if (!table->load(is, reader)) {
+        *this = {};
+        return false;
+      }
+      append(std::move(table));
+    }
+    return true;
+  }
+}
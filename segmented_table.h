@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+
+#include "record.h"
+#include "record_table.h"
+#include "filereader.h"
+
+namespace dlt {
+  // file-ordered sequence of independently parsed tables (e.g. one per chunk) addressed by a global row index
+  // segments are shared and never merged, so adding one costs the same no matter how many rows it holds
+  class SegmentedTable final {
+  public:
+    // take rows [from, table->size()) of the table. empty ranges are dropped
+    void append(std::shared_ptr<const RecordTable> table, std::size_t from = 0);
+    // the same for a table which continues parsing of the previous one: a corrupted record is reported once
+    // even if the corrupted area spans both of them
+    void splice(std::shared_ptr<const RecordTable> table, std::size_t from = 0);
+
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    // table holding the row and the index of the row in it. binary search over segments
+    [[nodiscard]] std::pair<const RecordTable&, std::size_t> locate(std::size_t index) const;
+    [[nodiscard]] Record get(std::size_t index) const;
+
+    // calls visitor(table, begin, end) for the rows [from, to) in order, once per segment they span
+    // [begin, end) are the rows of the table. used by bulk accessors to avoid the search per row
+    template <typename Visitor>
+    void forEachRange(std::size_t from, const std::size_t to, Visitor&& visitor) const {
+      assert(from <= to && to <= size());
+      if (from == to) {
+        return;
+      }
+      for (auto i = find(from); from != to; ++i) {
+        const auto begin = i == 0 ? 0 : ends_[i - 1];
+        const auto end = std::min(to, ends_[i]);
+        visitor(*segments_[i].table, segments_[i].from + from - begin, segments_[i].from + end - begin);
+        from = end;
+      }
+    }
+
+    // dumps of all the segments in order. used by the sidecar index
+    void save(std::ostream& os) const;
+    // returns false if the dump is broken or does not match the reader (the table is left empty then)
+    [[nodiscard]] bool load(std::istream& is, fs::reader& reader);
+
+  private:
+    struct segment {
+      std::shared_ptr<const RecordTable> table;
+      std::size_t from;
+    };
+
+    std::size_t find(std::size_t index) const;
+
+    std::vector<segment> segments_;
+    // global index past the last row of every segment
+    std::vector<std::size_t> ends_;
+    // whether the last row is corrupted. kept aside for splice: rows handed out may be formatted by their
+    // readers meanwhile, which writes the flags of the row
+    bool lastCorrupted_ = false;
+  };
+}
@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <array>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include "shard.h"
+#include "filereader.h"
+#include "record_table.h"
+#include "filter.h"
+
+namespace dlt {
+  namespace {
+    constexpr std::array<char, 8> MAGIC{ 'D', 'L', 'T', 'S', 'H', 'A', 'R', 'D' };
+    // bump on any change of shard_result::save layout
+    constexpr uint32_t VERSION = 1;
+
+    template <typename T>
+    void write(std::ostream& os, const T& value) {
+      os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void write(std::ostream& os, const std::string& str) {
+      write(os, static_cast<uint32_t>(str.size()));
+      os.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    void write(std::ostream& os, const shard_totals& totals) {
+      write(os, totals.records);
+      write(os, totals.corrupted);
+      write(os, totals.hits);
+      write(os, static_cast<uint64_t>(totals.apids.size()));
+      for (const auto& [apid, num] : totals.apids) {
+        write(os, apid);
+        write(os, num);
+      }
+      write(os, static_cast<uint64_t>(totals.histogram.size()));
+      for (const auto& [bucket, num] : totals.histogram) {
+        write(os, bucket);
+        write(os, num);
+      }
+    }
+
+    template <typename T>
+    bool read(std::istream& is, T& value) {
+      return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    bool read(std::istream& is, std::string& str) {
+      uint32_t size{};
+      if (!read(is, size)) {
+        return false;
+      }
+      // the result is small, a huge size is a broken dump rather than something to allocate
+      if (size > shard_result::HEAD_SIZE) {
+        return false;
+      }
+      str.resize(size);
+      return static_cast<bool>(is.read(str.data(), size));
+    }
+
+    bool read(std::istream& is, shard_totals& totals) {
+      uint64_t size{};
+      if (!read(is, totals.records) || !read(is, totals.corrupted) || !read(is, totals.hits) || !read(is, size)) {
+        return false;
+      }
+      totals.apids.clear();
+      for (uint64_t i = 0; i != size; ++i) {
+        std::string apid;
+        uint64_t num{};
+        if (!read(is, apid) || !read(is, num)) {
+          return false;
+        }
+        totals.apids.emplace(std::move(apid), num);
+      }
+      if (!read(is, size)) {
+        return false;
+      }
+      totals.histogram.clear();
+      for (uint64_t i = 0; i != size; ++i) {
+        uint64_t bucket{};
+        uint64_t num{};
+        if (!read(is, bucket) || !read(is, num)) {
+          return false;
+        }
+        totals.histogram.emplace(bucket, num);
+      }
+      return true;
+    }
+
+    // the end of the data a parse with the reader passed
+    std::size_t end_of(const fs::reader& reader) {
+      return reader.get_overrun() == fs::reader::OVERRUN_EOF ? reader.get_len() : reader.get_pos();
+    }
+
+    // evaluates shard_options over parsed rows. the records are parsed without parse_options::filter: every
+    // row is a point where the parse of the previous shard may meet this one
+    class shard_counter final {
+    public:
+      explicit shard_counter(const shard_options& options) : bucket_(std::max<uint64_t>(options.bucket, 1)) {
+        if (!options.filter.empty()) {
+          filter_.expression = filter_expression::compile(options.filter);
+        }
+        filter_.text = options.text;
+      }
+
+      [[nodiscard]] shard_result::row row(const RecordTable& table, const std::size_t index) const {
+        shard_result::row row{ table.getOffset(index), table.getTimeStamp(index), {}, table.isCorrupted(index), false };
+        if (row.corrupted) {
+          return row;
+        }
+        row.apid = table.getApid(index);
+        const filter_fields fields{
+          record_filter::make_id(table.getEcu(index)),
+          record_filter::make_id(table.getApid(index)),
+          record_filter::make_id(table.getCtid(index)),
+          table.getType(index),
+          table.getSubType(index),
+          row.time
+        };
+        row.hit = filter_.matches(fields)
+          && (filter_.text.empty() || table.getMessage(index).find(filter_.text) != std::string_view::npos);
+        return row;
+      }
+
+      void count(shard_totals& totals, const shard_result::row& row) const {
+        ++totals.records;
+        if (row.corrupted) {
+          ++totals.corrupted;
+          return;
+        }
+        totals.hits += row.hit;
+        ++totals.apids[row.apid];
+        ++totals.histogram[row.time / bucket_];
+      }
+
+    private:
+      uint64_t bucket_;
+      record_filter filter_;
+    };
+
+    std::unique_ptr<fs::reader> open_chunk(const shard_spec& spec) {
+      auto&& reader = fs::reader::factory(fs::reader_type::file_map, spec.path);
+      if (spec.count == 0 || spec.index >= spec.count || spec.count > reader->get_len()) {
+        throw std::invalid_argument("shard is out of the file");
+      }
+      return reader->chunk(spec.index, spec.count);
+    }
+
+    void combine(std::vector<shard_result>& results, shard_totals& totals) {
+      std::sort(results.begin(), results.end(), [](const shard_result& a, const shard_result& b) {
+        return a.spec.index < b.spec.index;
+      });
+      const auto& first = results.front();
+      for (std::size_t i = 0; i != results.size(); ++i) {
+        const auto& result = results[i];
+        if (result.spec.index != i || result.spec.count != first.spec.count || result.file_size != first.file_size
+          || !(result.options == first.options)) {
+          throw std::runtime_error("shards of " + first.spec.path.string() + " do not belong together");
+        }
+      }
+      if (results.size() != first.spec.count) {
+        throw std::runtime_error("shards of " + first.spec.path.string() + " are missing");
+      }
+
+      const shard_counter counter(first.options);
+      const auto len = first.file_size;
+      // see supervisor::merge. the parse of a shard started at its beginning, so it is in sync there as well
+      uint64_t covered = 0;
+      for (const auto& result : results) {
+        const auto& head = result.head;
+        auto from = static_cast<std::size_t>(std::lower_bound(head.cbegin(), head.cend(), covered,
+          [](const shard_result::row& row, const uint64_t offset) { return row.offset < offset; }) - head.cbegin());
+        const auto is_row = [&head](const std::size_t row, const uint64_t offset) {
+          return row < head.size() && head[row].offset == offset;
+        };
+        const bool passed = from == head.size() && result.rest.records == 0 && result.covered <= covered;
+        const bool in_sync = covered == result.begin || is_row(from, covered) || passed;
+        if (!in_sync && covered < len) {
+          // rows past the head are not known one by one: the shard is reparsed as a whole if they are not met before
+          auto&& reader = open_chunk(result.spec)->fork(covered);
+          if (reader->get_len() != len) {
+            throw std::runtime_error(result.spec.path.string() + " changed since it was parsed");
+          }
+          parse_options options;
+          options.lazy_message = true;
+          RecordTable reparsed;
+          bool synced = false;
+          while (!synced && reparsed.try_parse(*reader, options) != errc::eof && reader->get_overrun() == 0) {
+            const auto pos = reader->get_pos();
+            from = static_cast<std::size_t>(std::lower_bound(head.cbegin(), head.cend(), pos,
+              [](const shard_result::row& row, const uint64_t offset) { return row.offset < offset; }) - head.cbegin());
+            synced = is_row(from, pos);
+          }
+
+          for (std::size_t i = 0; i != reparsed.size(); ++i) {
+            counter.count(totals, counter.row(reparsed, i));
+          }
+          if (!synced) {
+            covered = std::max<uint64_t>(covered, end_of(*reader));
+            continue;
+          }
+        }
+
+        for (auto i = from; i < head.size(); ++i) {
+          counter.count(totals, head[i]);
+        }
+        totals.merge(result.rest);
+        covered = std::max(covered, result.covered);
+      }
+    }
+  }
+
+  void shard_totals::merge(const shard_totals& other) {
+    records += other.records;
+    corrupted += other.corrupted;
+    hits += other.hits;
+    for (const auto& [apid, num] : other.apids) {
+      apids[apid] += num;
+    }
+    for (const auto& [bucket, num] : other.histogram) {
+      histogram[bucket] += num;
+    }
+  }
+
+  void shard_result::save(std::ostream& os) const {
+    os.write(MAGIC.data(), MAGIC.size());
+    write(os, VERSION);
+    write(os, spec.path.string());
+    write(os, spec.index);
+    write(os, spec.count);
+    write(os, options.filter);
+    write(os, options.text);
+    write(os, options.bucket);
+    write(os, file_size);
+    write(os, begin);
+    write(os, end);
+    write(os, covered);
+    write(os, static_cast<uint64_t>(head.size()));
+    for (const auto& row : head) {
+      write(os, row.offset);
+      write(os, row.time);
+      write(os, row.apid);
+      write(os, static_cast<uint8_t>(row.corrupted | row.hit << 1));
+    }
+    write(os, head_until);
+    write(os, rest);
+  }
+
+  bool shard_result::load(std::istream& is) {
+    std::array<char, 8> magic{};
+    uint32_t version{};
+    std::string path;
+    if (!is.read(magic.data(), magic.size()) || magic != MAGIC || !read(is, version) || version != VERSION
+      || !read(is, path) || !read(is, spec.index) || !read(is, spec.count) || !read(is, options.filter)
+      || !read(is, options.text) || !read(is, options.bucket) || !read(is, file_size) || !read(is, begin)
+      || !read(is, end) || !read(is, covered)) {
+      return false;
+    }
+    spec.path = path;
+
+    uint64_t size{};
+    // every row takes more than HEAD_SIZE / size bytes of the file
+    if (!read(is, size) || size > HEAD_SIZE) {
+      return false;
+    }
+    head.resize(size);
+    for (auto& row : head) {
+      uint8_t flags{};
+      if (!read(is, row.offset) || !read(is, row.time) || !read(is, row.apid) || !read(is, flags)) {
+        return false;
+      }
+      row.corrupted = flags & 1;
+      row.hit = flags & 2;
+    }
+    return read(is, head_until) && read(is, rest);
+  }
+
+  std::vector<shard_spec> plan_shards(const std::vector<std::filesystem::path>& files, const std::size_t shard_size) {
+    std::vector<shard_spec> shards;
+    for (const auto& path : files) {
+      const auto size = std::filesystem::file_size(path);
+      const auto count = static_cast<uint32_t>((size + shard_size - 1) / std::max<std::size_t>(shard_size, 1));
+      for (uint32_t i = 0; i != count; ++i) {
+        shards.push_back({ path, i, count });
+      }
+    }
+    return shards;
+  }
+
+  shard_result parse_shard(const shard_spec& spec, const shard_options& options) {
+    const shard_counter counter(options);
+    auto&& reader = open_chunk(spec);
+
+    shard_result result;
+    result.spec = spec;
+    result.options = options;
+    result.file_size = reader->get_len();
+    // the same bounds as of the split
+    result.begin = result.file_size / spec.count * spec.index;
+    result.end = spec.index + 1 == spec.count ? result.file_size : result.file_size / spec.count * (spec.index + 1);
+    result.head_until = std::min(result.begin + shard_result::HEAD_SIZE, result.file_size);
+
+    // the same as task::execute
+    parse_options parse;
+    parse.lazy_message = true;
+    RecordTable table;
+    while (table.try_parse(*reader, parse) != errc::eof && reader->get_overrun() == 0) {
+    }
+    result.covered = end_of(*reader);
+
+    for (std::size_t i = 0; i != table.size(); ++i) {
+      auto&& row = counter.row(table, i);
+      if (row.offset < result.head_until) {
+        result.head.push_back(std::move(row));
+      }
+      else {
+        counter.count(result.rest, row);
+      }
+    }
+    return result;
+  }
+
+  std::map<std::string, shard_totals> combine_shards(std::vector<shard_result> results) {
+    std::map<std::string, std::vector<shard_result>> files;
+    for (auto& result : results) {
+      files[result.spec.path.string()].push_back(std::move(result));
+    }
+
+    std::map<std::string, shard_totals> totals;
+    for (auto& [path, file_results] : files) {
+      combine(file_results, totals[path]);
+    }
+    return totals;
+  }
+}
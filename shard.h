@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+// parsing of big trace archives by several processes (or machines sharing the storage)
+// every file is split into shards along the same bounds fs::reader::split uses, a worker parses one shard into
+// a compact shard_result and the coordinator stitches the results of a file in order the way supervisor::merge
+// stitches chunks: records of the previous shard are skipped and a shard which starts out of sync is reparsed
+namespace dlt {
+  // one unit of work: chunk index of count chunks of the file
+  struct shard_spec {
+    std::filesystem::path path;
+    uint32_t index = 0;
+    uint32_t count = 1;
+  };
+
+  // what a worker computes. it is kept in the results, so the coordinator reparses with the same options
+  struct shard_options {
+    // filter_expression of the records to count as hits, empty matches all
+    std::string filter;
+    // substring of the message the hits must contain as well, empty matches all
+    std::string text;
+    // width of a time histogram bucket, storage header time in microseconds
+    uint64_t bucket = 60'000'000;
+
+    bool operator==(const shard_options& other) const = default;
+  };
+
+  // aggregates over records
+  struct shard_totals {
+    uint64_t records = 0;
+    uint64_t corrupted = 0;
+    // records matching shard_options. corrupted ones never match
+    uint64_t hits = 0;
+    // of the records which are not corrupted
+    std::map<std::string, uint64_t> apids;
+    // storage header time / bucket to the number of records which are not corrupted
+    std::map<uint64_t, uint64_t> histogram;
+
+    void merge(const shard_totals& other);
+  };
+
+  struct shard_result {
+    // a record near the beginning of the shard which the coordinator may need to skip
+    struct row {
+      uint64_t offset;
+      uint64_t time;
+      std::string apid;
+      bool corrupted;
+      bool hit;
+    };
+
+    // rows starting this far from the beginning of the chunk are kept one by one. the previous shard
+    // covers one record past its end (unless the border is corrupted), so this is enough to meet it
+    static constexpr uint64_t HEAD_SIZE = 256 * 1024;
+
+    shard_spec spec;
+    shard_options options;
+    uint64_t file_size = 0;
+    // the chunk is [begin, end) of the file
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    // end of the data the parse of the chunk passed: the file size if it ran into eof
+    uint64_t covered = 0;
+    // rows at offsets before head_until in file order
+    std::vector<row> head;
+    uint64_t head_until = 0;
+    // records at head_until and after
+    shard_totals rest;
+
+    void save(std::ostream& os) const;
+    // returns false if the dump is broken
+    [[nodiscard]] bool load(std::istream& is);
+  };
+
+  // shards of at most shard_size bytes each. empty files have none
+  [[nodiscard]] std::vector<shard_spec> plan_shards(const std::vector<std::filesystem::path>& files,
+    std::size_t shard_size);
+
+  // throws std::invalid_argument if the filter does not compile
+  [[nodiscard]] shard_result parse_shard(const shard_spec& spec, const shard_options& options);
+
+  // totals by file (path as it was given to the workers). results may come in any order
+  // throws std::runtime_error if results of a file are missing, duplicated or do not belong together
+  [[nodiscard]] std::map<std::string, shard_totals> combine_shards(std::vector<shard_result> results);
+}
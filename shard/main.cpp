@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+
+#include "../shard.h"
+
+/* for lld */
+#ifdef __llvm__
+# pragma comment(lib, "fmt")
+#	pragma comment(lib, "boost_iostreams-vc140-mt")
+# ifdef DLT_WITH_GZIP
+#  pragma comment(lib, "zlib")
+# endif
+# ifdef DLT_WITH_XZ
+#  pragma comment(lib, "lzma")
+# endif
+# ifdef DLT_WITH_ZSTD
+#  pragma comment(lib, "zstd")
+# endif
+#endif
+
+// shard plan <results dir> [--shard-size bytes] [options] <file>...
+// shard work <file> <index> <count> <result> [options]
+// shard combine <result>...
+// shard run <results dir> [--processes N] [--shard-size bytes] [options] <file>...
+// options: [--filter expression] [--text substring] [--bucket seconds]
+namespace {
+  constexpr std::string_view USAGE =
+    "usage:\n"
+    "  shard plan <results dir> [--shard-size bytes] [options] <file>...\n"
+    "      prints the worker command of every shard, run them anywhere the files and the directory are reachable\n"
+    "  shard work <file> <index> <count> <result> [options]\n"
+    "  shard combine <result>...\n"
+    "  shard run <results dir> [--processes N] [--shard-size bytes] [options] <file>...\n"
+    "      plan, run the workers as local processes and combine\n"
+    "options:\n"
+    "  --filter expression   records to count as hits, e.g. \"apid == APP1 and level <= warn\"\n"
+    "  --text substring      hits must contain it as well\n"
+    "  --bucket seconds      time histogram bucket, 60 by default\n";
+
+  constexpr std::size_t DEFAULT_SHARD_SIZE = 256 * 1024 * 1024;
+
+  // every option takes a value, everything else is positional
+  class arguments final {
+  public:
+    arguments(const int argc, char** argv) {
+      for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.substr(0, 2) == "--" && i + 1 < argc) {
+          options_.emplace_back(arg, argv[++i]);
+        }
+        else {
+          positional_.push_back(argv[i]);
+        }
+      }
+    }
+
+    [[nodiscard]] const char* value(const std::string_view name) const {
+      for (const auto& [option, value] : options_) {
+        if (option == name) {
+          return value;
+        }
+      }
+      return nullptr;
+    }
+
+    [[nodiscard]] double number(const std::string_view name, const double fallback) const {
+      const auto str = value(name);
+      return str ? std::strtod(str, nullptr) : fallback;
+    }
+
+    [[nodiscard]] const std::vector<const char*>& positional() const noexcept {
+      return positional_;
+    }
+
+    [[nodiscard]] dlt::shard_options shard_options() const {
+      dlt::shard_options options;
+      if (const auto filter = value("--filter")) {
+        options.filter = filter;
+      }
+      if (const auto text = value("--text")) {
+        options.text = text;
+      }
+      options.bucket = static_cast<uint64_t>(number("--bucket", static_cast<double>(options.bucket) / 1e6) * 1e6);
+      return options;
+    }
+
+  private:
+    std::vector<std::pair<std::string_view, const char*>> options_;
+    std::vector<const char*> positional_;
+  };
+
+  std::string quote(const std::string_view arg) {
+    std::string result = "\"";
+    for (const auto c : arg) {
+#ifdef _WIN32
+      if (c == '"') {
+        result += '"';
+      }
+#else
+      if (c == '"' || c == '\\' || c == '$' || c == '`') {
+        result += '\\';
+      }
+#endif
+      result += c;
+    }
+    return result += '"';
+  }
+
+  struct job {
+    dlt::shard_spec spec;
+    std::filesystem::path result;
+    std::string command;
+  };
+
+  std::vector<job> plan(const std::string_view self, const arguments& args) {
+    const auto& positional = args.positional();
+    const std::filesystem::path dir = positional[0];
+    const std::vector<std::filesystem::path> files(positional.begin() + 1, positional.end());
+    const auto shard_size = static_cast<std::size_t>(args.number("--shard-size", DEFAULT_SHARD_SIZE));
+    const auto options = args.shard_options();
+
+    std::vector<job> jobs;
+    for (auto&& spec : dlt::plan_shards(files, shard_size)) {
+      auto result = dir / fmt::format("{:06}.shard", jobs.size());
+      auto command = fmt::format("{} work {} {} {} {} --bucket {}", quote(self), quote(spec.path.string()),
+        spec.index, spec.count, quote(result.string()), static_cast<double>(options.bucket) / 1e6);
+      if (!options.filter.empty()) {
+        command += " --filter " + quote(options.filter);
+      }
+      if (!options.text.empty()) {
+        command += " --text " + quote(options.text);
+      }
+      jobs.push_back({ std::move(spec), std::move(result), std::move(command) });
+    }
+    return jobs;
+  }
+
+  int work(const arguments& args) {
+    const auto& positional = args.positional();
+    if (positional.size() != 4) {
+      std::cerr << USAGE;
+      return 2;
+    }
+    const dlt::shard_spec spec{ positional[0], static_cast<uint32_t>(std::strtoul(positional[1], nullptr, 10)),
+      static_cast<uint32_t>(std::strtoul(positional[2], nullptr, 10)) };
+    const std::filesystem::path path = positional[3];
+
+    const auto result = dlt::parse_shard(spec, args.shard_options());
+    // the result is written to a temporary file first: a half-written one must never be combined
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+      std::ofstream os(temp_path, std::ios::binary | std::ios::trunc);
+      result.save(os);
+      if (!os.flush()) {
+        throw std::runtime_error("failed to write " + temp_path.string());
+      }
+    }
+    std::filesystem::rename(temp_path, path);
+    return 0;
+  }
+
+  void print(const std::string_view name, const dlt::shard_totals& totals, const uint64_t bucket) {
+    std::cout << fmt::format("{}: {} records, {} corrupted, {} hits\n", name, totals.records, totals.corrupted, totals.hits);
+    std::vector<std::pair<std::string, uint64_t>> apids(totals.apids.cbegin(), totals.apids.cend());
+    std::stable_sort(apids.begin(), apids.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    for (const auto& [apid, num] : apids) {
+      std::cout << fmt::format("  apid {:<4} {:>12}\n", apid, num);
+    }
+    for (const auto& [time, num] : totals.histogram) {
+      std::cout << fmt::format("  time {:>12} {:>12}\n", time * bucket / 1'000'000, num);
+    }
+  }
+
+  int combine(const std::vector<std::filesystem::path>& paths) {
+    std::vector<dlt::shard_result> results;
+    results.reserve(paths.size());
+    for (const auto& path : paths) {
+      std::ifstream is(path, std::ios::binary);
+      if (!results.emplace_back().load(is)) {
+        throw std::runtime_error(path.string() + " is not a shard result");
+      }
+    }
+    if (results.empty()) {
+      return 0;
+    }
+
+    // histograms of the files are summed up in the total
+    const auto bucket = results.front().options.bucket;
+    if (std::any_of(results.cbegin(), results.cend(), [bucket](const auto& result) { return result.options.bucket != bucket; })) {
+      throw std::runtime_error("shard results have different time buckets");
+    }
+    const auto files = dlt::combine_shards(std::move(results));
+    dlt::shard_totals total;
+    for (const auto& [path, totals] : files) {
+      print(path, totals, bucket);
+      total.merge(totals);
+    }
+    if (files.size() > 1) {
+      print("total", total, bucket);
+    }
+    return 0;
+  }
+
+  int run(const std::string_view self, const arguments& args) {
+    const auto jobs = plan(self, args);
+    std::filesystem::create_directories(args.positional()[0]);
+    const auto processes = static_cast<unsigned>(args.number("--processes", std::thread::hardware_concurrency()));
+
+    // a worker is a process, a thread only waits for it
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<std::size_t> failed{ 0 };
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i != std::max(processes, 1u); ++i) {
+      threads.emplace_back([&]() {
+        for (auto job = next++; job < jobs.size(); job = next++) {
+#ifdef _WIN32
+          // cmd strips the outer quotes of the whole line
+          const auto status = std::system(("\"" + jobs[job].command + "\"").c_str());
+#else
+          const auto status = std::system(jobs[job].command.c_str());
+#endif
+          failed += status != 0;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (failed != 0) {
+      std::cerr << fmt::format("{} of {} workers failed\n", failed.load(), jobs.size());
+      return 1;
+    }
+
+    std::vector<std::filesystem::path> results;
+    results.reserve(jobs.size());
+    for (const auto& job : jobs) {
+      results.push_back(job.result);
+    }
+    return combine(results);
+  }
+}
+
+int main(const int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << USAGE;
+    return 2;
+  }
+
+  const std::string_view command = argv[1];
+  const arguments args(argc, argv);
+  try {
+    if (command == "plan" && args.positional().size() >= 2) {
+      for (const auto& job : plan(argv[0], args)) {
+        std::cout << job.command << '\n';
+      }
+      return 0;
+    }
+    if (command == "work") {
+      return work(args);
+    }
+    if (command == "combine") {
+      return combine({ args.positional().begin(), args.positional().end() });
+    }
+    if (command == "run" && args.positional().size() >= 2) {
+      return run(argv[0], args);
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  std::cerr << USAGE;
+  return 2;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// parse instrumentation. counters and timers are updated only if built with DLT_WITH_STATS, otherwise
+// DLT_STATS(...) expands to nothing and only the numbers derived from the results are filled (see parse_stats)
+#ifdef DLT_WITH_STATS
+# define DLT_STATS(...) __VA_ARGS__
+#else
+# define DLT_STATS(...)
+#endif
+
+namespace dlt {
+  using nanoseconds = uint64_t;
+
+  // adds the lifetime of the scope to the counter
+  class scoped_timer final {
+  public:
+    explicit scoped_timer(nanoseconds& counter) noexcept : counter_(counter), start_(clock::now()) {
+    }
+
+    scoped_timer(const scoped_timer&) = delete;
+    scoped_timer& operator=(const scoped_timer&) = delete;
+
+    ~scoped_timer() {
+      counter_ += static_cast<nanoseconds>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+    }
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    nanoseconds& counter_;
+    const clock::time_point start_;
+  };
+
+  // gathered by a reader, every clone has its own
+  struct io_stats {
+    // skipped looking for the next storage header after corrupted data
+    uint64_t resync_bytes = 0;
+    // blocked on data which is not loaded yet (file_precache, file_stream)
+    nanoseconds wait = 0;
+  };
+
+  // gathered by RecordTable::try_parse
+  struct table_stats {
+    // records dropped by parse_options::filter
+    uint64_t filtered = 0;
+    // eager formatting of messages (lazy ones are formatted on access)
+    nanoseconds format = 0;
+  };
+
+  // one chunk of the file parsed by one task
+  struct task_stats {
+    /* always filled */
+    // the chunk is [begin, end) of the file
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    // where parsing of the chunk stopped
+    std::size_t parsed_until = 0;
+    // bytes of the record crossing the end of the chunk read past it, 0 if parsing ran into the end of file
+    std::size_t overrun = 0;
+    uint64_t records = 0;
+    uint64_t corrupted = 0;
+
+    /* DLT_WITH_STATS only */
+    io_stats io;
+    table_stats table;
+    // whole task
+    nanoseconds parse = 0;
+  };
+
+  // of one supervisor::execute
+  struct parse_stats {
+    static constexpr bool enabled = DLT_STATS(true ||) false;
+
+    std::vector<task_stats> tasks;
+    // parsed once again by merge because a chunk started out of sync
+    std::size_t reparsed_bytes = 0;
+    /* DLT_WITH_STATS only */
+    // of the tables merge reparsed, the tasks count the rest
+    table_stats reparsed;
+    nanoseconds merge = 0;
+    nanoseconds total = 0;
+  };
+}
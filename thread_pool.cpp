@@ -0,0 +1,78 @@
+#include <atomic>
+#include <algorithm>
+
+#include "thread_pool.h"
+#include "thread_supervisor.h"
+
+namespace dlt {
+  thread_pool& thread_pool::instance() {
+    // the thread which submits jobs always works on them too, hence one worker less than cores
+    // never destroyed: joining threads while the module is being unloaded deadlocks on the loader lock
+    static auto* const pool = new thread_pool(supervisor::cores_num - 1);
+    return *pool;
+  }
+
+  thread_pool::thread_pool(const unsigned threads_num) {
+    threads_.reserve(threads_num);
+    for (unsigned i = 0; i != threads_num; ++i) {
+      threads_.emplace_back(&thread_pool::work, this);
+    }
+  }
+
+  unsigned thread_pool::size() const noexcept {
+    return static_cast<unsigned>(threads_.size());
+  }
+
+  void thread_pool::submit(std::function<void()> job) {
+    {
+      std::lock_guard lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    ready_.notify_one();
+  }
+
+  void thread_pool::parallel_for(const std::size_t count, const std::function<void(std::size_t)>& job,
+    const unsigned concurrency) {
+    // the calling thread is one of the workers, the rest are borrowed from the pool
+    // a single job is executed right here without any synchronization
+    std::atomic<std::size_t> next{ 0 };
+    const auto worker = [&next, count, &job]() {
+      for (auto i = next++; i < count; i = next++) {
+        job(i);
+      }
+    };
+
+    const auto helpers_num = static_cast<unsigned>(std::min<std::size_t>({
+      count ? count - 1 : 0, concurrency ? concurrency - 1 : 0, size() }));
+
+    std::mutex mutex;
+    std::condition_variable done;
+    auto pending = helpers_num;
+    for (unsigned i = 0; i != helpers_num; ++i) {
+      submit([&]() {
+        worker();
+        // notify under lock: the waiter may destroy done as soon as it sees pending == 0
+        std::lock_guard lock(mutex);
+        --pending;
+        done.notify_one();
+      });
+    }
+    worker();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [&pending]() { return pending == 0; });
+  }
+
+  void thread_pool::work() {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock lock(mutex_);
+        ready_.wait(lock, [this]() { return !jobs_.empty(); });
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      job();
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace dlt {
+  // process-wide workers shared by all the supervisors, so parsing many small files does not pay
+  // for thread creation every time
+  class thread_pool final {
+  public:
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // workers are started on the first call
+    [[nodiscard]]
+    static thread_pool& instance();
+
+    [[nodiscard]]
+    unsigned size() const noexcept;
+
+    // job is executed by one of the workers. it must not throw
+    void submit(std::function<void()> job);
+
+    // calls job(i) for every i in [0, count) by at most concurrency threads including the calling one
+    // and returns once all of them are done. job must not throw nor call parallel_for itself
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& job, unsigned concurrency);
+
+  private:
+    explicit thread_pool(unsigned threads_num);
+    void work();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> threads_;
+  };
+}
@@ -1,12 +1,38 @@
-#include <thread>
-#include <type_traits>
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "thread_supervisor.h"
+#include "thread_pool.h"
 #include "exceptions.h"
 
 namespace dlt {
-  task::task(std::unique_ptr<fs::reader> reader) : reader_(std::move(reader)) {
+  void parse_failure::set(std::exception_ptr exception) noexcept {
+    std::lock_guard lock(mutex_);
+    if (exception_ == nullptr) {
+      exception_ = std::move(exception);
+      failed_.store(true, std::memory_order_release);
+    }
+  }
+
+  bool parse_failure::is_set() const noexcept {
+    return failed_.load(std::memory_order_acquire);
+  }
+
+  void parse_failure::rethrow() {
+    std::unique_lock lock(mutex_);
+    if (exception_ != nullptr) {
+      const auto exception = std::exchange(exception_, nullptr);
+      failed_.store(false, std::memory_order_release);
+      lock.unlock();
+      std::rethrow_exception(exception);
+    }
+  }
+
+  task::task(std::unique_ptr<fs::reader> reader, const parse_options& options, const std::size_t begin,
+    const std::size_t end, const std::atomic<bool>& cancelled, parse_failure& failure)
+    : reader_(std::move(reader)), options_(options), begin_(begin), end_(end), cancelled_(&cancelled),
+    failure_(&failure) {
   }
 
   const fs::reader& task::get_reader() const {
@@ -14,113 +40,220 @@ namespace dlt {
   }
 
   void task::execute() {
-    // if parse exception occured push corrupted record if no others in a row
-    // this is to be in compliance with DLT viewer
-    const auto parse_exception_handler = [this](const Record& record) {
-      // TODO: log
-      if(records_.size() == 0 || !records_.back().isCorrupted()) {
-        records_.push_back(record);
-      }
-    };
-
-    while (true) {
+    DLT_STATS(const scoped_timer timer(parse_time_));
+    // if exception was raised by another chunk of the file - cancel execution
+    while (!failure_->is_set() && !cancelled_->load(std::memory_order_relaxed)) {
       try {
-        Record record;
-        record.parse(*reader_, parse_exception_handler);
-        // we do not emplace anymore because parse may throw
-        records_.push_back(std::move(record));
-
-        // check if we overruned current chunk
-        if (reader_->get_overrun() > 0) {
-          throw except::eof{};
-        }
-
-        // if exception was raised somewhere in another thread - cancel execution
-        if (supervisor::exception_ptr_holder != nullptr) {
+        // corrupted records are pushed by the table itself
+        if (records_->try_parse(*reader_, options_) == errc::eof) {
           break;
         }
       }
-      catch (const except::eof&) {
+      catch(...) {
+        failure_->set(std::current_exception());
         break;
       }
-      catch(...) {
-        supervisor::exception_ptr_holder = std::current_exception();
+
+      // check if we overruned current chunk
+      if (reader_->get_overrun() > 0) {
         break;
       }
     }
+    // only position and overrun of the reader are needed from now on
+    reader_->release();
   }
 
-  std::vector<Record>& task::result() {
+  const std::shared_ptr<RecordTable>& task::result() const {
     return records_;
   }
 
-  supervisor::supervisor(fs::reader&& reader) {
-    // threads_num_ should be configurable defaulting to the number of cores
-    threads_num_ = cores_num;
+  task_stats task::stats() const {
+    task_stats stats;
+    stats.begin = begin_;
+    stats.end = end_;
+    stats.parsed_until = std::min(reader_->get_pos(), reader_->get_len());
+    const auto overrun = reader_->get_overrun();
+    stats.overrun = overrun != fs::reader::OVERRUN_EOF && overrun > end_ ? overrun - end_ : 0;
+    stats.records = records_->size();
+    for (std::size_t i = 0; i != records_->size(); ++i) {
+      stats.corrupted += records_->isCorrupted(i);
+    }
+    stats.io = reader_->get_io_stats();
+    stats.table = records_->getStats();
+    DLT_STATS(stats.parse = parse_time_);
+    return stats;
+  }
 
-    auto&& readers = reader.split(threads_num_);
+  supervisor::supervisor(fs::reader&& reader, const parse_options& options, const unsigned threads_num,
+    const std::size_t chunk_size) : len_(reader.get_len()), options_(options) {
+    assert(chunk_size > 0);
+    const auto chunks_num = std::max<std::size_t>(1, (len_ + chunk_size - 1) / chunk_size);
 
-    tasks_.reserve(threads_num_);
-    for (size_t i = 0; i != threads_num_; ++i) {
-      tasks_.emplace_back(std::move(readers[i]));
+    // there is no point in threads which will never get a chunk
+    threads_num_ = static_cast<unsigned>(std::min<std::size_t>(threads_num ? threads_num : cores_num, chunks_num));
+
+    auto&& readers = reader.split(chunks_num);
+
+    tasks_.reserve(chunks_num);
+    for (size_t i = 0; i != chunks_num; ++i) {
+      // the same bounds as of the split
+      const auto end = i + 1 == chunks_num ? len_ : len_ / chunks_num * (i + 1);
+      tasks_.emplace_back(std::move(readers[i]), options, len_ / chunks_num * i, end, *cancelled_, *failure_);
     }
   }
 
-  void supervisor::execute(std::vector<Record>& records) {
-    std::vector<std::thread> threads(threads_num_);
+  std::size_t supervisor::execute(SegmentedTable& records) {
+    DLT_STATS(const scoped_timer timer(total_time_));
+    // chunks are independent and of equal size, so a shared cursor balances the load as well as
+    // per-thread queues with stealing would, at the cost of one atomic increment per chunk
+    thread_pool::instance().parallel_for(tasks_.size(), [this](const std::size_t i) {
+      tasks_[i].execute();
+    }, threads_num_);
+
+    failure_->rethrow();
+    merged_ = 0;
+    covered_ = 0;
+    merge(records, tasks_.size());
+    return covered_;
+  }
+
+  std::size_t supervisor::execute(SegmentedTable& records, std::mutex& records_mutex,
+    const std::function<void(std::size_t)>& stitched) {
+    merged_ = 0;
+    covered_ = 0;
+    // whoever completes the prefix stitches it. a cancelled parse leaves chunks half-done: they are not stitched
+    std::mutex merge_mutex;
+    std::vector<bool> done(tasks_.size());
+    thread_pool::instance().parallel_for(tasks_.size(), [&](const std::size_t i) {
+      tasks_[i].execute();
 
-    for (size_t i = 0; i != threads_num_; ++i) {
-      threads[i] = std::thread{[this, i]() { tasks_[i].execute(); }};
+      std::lock_guard lock(merge_mutex);
+      done[i] = true;
+      auto until = merged_;
+      while (until != tasks_.size() && done[until]) {
+        ++until;
+      }
+      if (until == merged_ || failure_->is_set() || cancelled_->load()) {
+        return;
+      }
+      try {
+        std::lock_guard records_lock(records_mutex);
+        merge(records, until);
+      }
+      catch (...) {
+        failure_->set(std::current_exception());
+        return;
+      }
+      stitched(covered_);
+    }, threads_num_);
+
+    failure_->rethrow();
+    return covered_;
+  }
+
+  void supervisor::cancel() noexcept {
+    cancelled_->store(true);
+  }
+
+  std::vector<std::size_t> supervisor::execute(std::vector<supervisor>& supervisors,
+    std::vector<SegmentedTable>& records) {
+    // the files share the threads, so each one is accounted the whole time
+    DLT_STATS(const auto start = std::chrono::steady_clock::now());
+    std::vector<task*> tasks;
+    unsigned threads_num = 1;
+    for (auto& supervisor : supervisors) {
+      for (auto& task : supervisor.tasks_) {
+        tasks.push_back(&task);
+      }
+      threads_num = std::max(threads_num, supervisor.threads_num_);
     }
 
-    // firstly wait for all threads and store results
-    std::vector<std::remove_reference_t<decltype(tasks_[0].result())>> results;
-    results.reserve(threads_num_);
-    for (size_t i = 0; i != threads_num_; ++i) {
-      threads[i].join();
-      results.push_back(std::move(tasks_[i].result()));
+    // small files are a single chunk each, hence they are parsed in parallel with each other
+    thread_pool::instance().parallel_for(tasks.size(), [&tasks](const std::size_t i) {
+      tasks[i]->execute();
+    }, std::max(threads_num, static_cast<unsigned>(std::min<std::size_t>(tasks.size(), cores_num))));
+    for (auto& supervisor : supervisors) {
+      supervisor.failure_->rethrow();
     }
 
-    // secondly store results contiguously...
-    records = std::move(results[0]);
-    // reserve enough space and then just copy into the memory
-    // this thing is a bit non-standard (UB)
-    // actually, the standard forbids accessing reserved but non-resized
-    // but since this memory is contigously allocated we are sure that everything goes well
-    // otherwise the overhead zeroing would be performed
-    std::size_t size{ 0 };
-    for (size_t i = 0; i != threads_num_; ++i) {
-      size += results[i].size();
+    records.resize(supervisors.size());
+    std::vector<std::size_t> ends;
+    ends.reserve(supervisors.size());
+    for (std::size_t i = 0; i != supervisors.size(); ++i) {
+      auto& supervisor = supervisors[i];
+      supervisor.merged_ = 0;
+      supervisor.covered_ = 0;
+      supervisor.merge(records[i], supervisor.tasks_.size());
+      ends.push_back(supervisor.covered_);
     }
-    records.reserve(size);
-
-    for(size_t i=1; i != threads_num_; ++i) {
-      // the whole point of this check is to determine wheter the corrupted record is
-      // a result of splitting into chunks or not
-      // if so, we just remove that corrupted record
-      // we also remove it if overrun is because eof for two tasks in a row
-      // this means that some chunks do not have any records at all. we do assert in such a case
-      bool skip_first_record{ false };
-      if (results[i].size() > 0 && results[i][0].isCorrupted()) {
-        const auto prev_overrun = tasks_[i - 1].get_reader().get_overrun();
-        const auto cur_overrun = tasks_[i].get_reader().get_overrun();
-        const auto cur_valid_offset = tasks_[i].get_reader().get_first_valid_offset();
-
-        if ((prev_overrun > 0 && prev_overrun == cur_valid_offset) 
-          || (prev_overrun == fs::reader::OVERRUN_EOF && cur_overrun == fs::reader::OVERRUN_EOF && 
-            (assert(results[i].size() == 1), true))) {
-          skip_first_record = true;
+    DLT_STATS(for (auto& supervisor : supervisors) {
+      supervisor.total_time_ = static_cast<nanoseconds>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    })
+    return ends;
+  }
+
+  parse_stats supervisor::stats() const {
+    parse_stats stats;
+    stats.tasks.reserve(tasks_.size());
+    for (const auto& task : tasks_) {
+      stats.tasks.push_back(task.stats());
+    }
+    stats.reparsed_bytes = reparsed_bytes_;
+    DLT_STATS(stats.reparsed = reparsed_stats_);
+    DLT_STATS(stats.merge = merge_time_);
+    DLT_STATS(stats.total = total_time_);
+    return stats;
+  }
+
+  void supervisor::merge(SegmentedTable& records, const std::size_t until) {
+    DLT_STATS(const scoped_timer timer(merge_time_));
+    if (merged_ == 0) {
+      reparsed_bytes_ = 0;
+      DLT_STATS(reparsed_stats_ = {});
+    }
+    // every chunk is parsed until the first record which crosses its end, so the beginning of the next chunk
+    // is covered already. the next chunk is in sync if it has a record (or a remembered filtered one, see
+    // RecordTable::isSyncPoint) exactly where the covered part ends, everything before is skipped: these are
+    // the records of the previous chunk or garbage from splitting in the middle of a record. otherwise
+    // (corruption around the border or an entirely covered chunk) the chunk is reparsed from the covered offset
+    // until it meets one of its records
+    // chunk which ran into eof covers everything till the end of file
+    const auto end_of = [this](const fs::reader& reader) {
+      return reader.get_overrun() == fs::reader::OVERRUN_EOF ? len_ : reader.get_pos();
+    };
+
+    auto& covered = covered_;
+    for (; merged_ != until; ++merged_) {
+      const auto& task = tasks_[merged_];
+      const auto& result = *task.result();
+      const auto& chunk_reader = task.get_reader();
+
+      auto from = result.lowerBound(covered);
+      const bool in_sync = result.isSyncPoint(covered) || (from == result.size() && end_of(chunk_reader) <= covered);
+      if (!in_sync && covered < len_) {
+        auto&& reader = chunk_reader.fork(covered);
+        auto reparsed = std::make_shared<RecordTable>();
+        bool synced = false;
+        while (!synced && reparsed->try_parse(*reader, options_) != errc::eof && reader->get_overrun() == 0) {
+          const auto pos = reader->get_pos();
+          from = result.lowerBound(pos);
+          synced = result.isSyncPoint(pos);
+        }
+
+        reparsed_bytes_ += std::min(reader->get_pos(), len_) - covered;
+        DLT_STATS(reparsed_stats_.filtered += reparsed->getStats().filtered);
+        DLT_STATS(reparsed_stats_.format += reparsed->getStats().format);
+        records.splice(std::move(reparsed));
+        if (!synced) {
+          // the whole chunk was reparsed
+          covered = std::max(covered, end_of(*reader));
+          continue;
         }
       }
 
-      // if the first record is corrupted because it was splitted into chunks in the middle it will be skipped
-      // such record itself is a part of previous chunk no matter if it is correct or not
-      std::move(std::begin(results[i]) + (skip_first_record ? 1 : 0), std::end(results[i]), std::back_inserter(records));
-    }
-    
-    // if exception was raised rethrow
-    if (exception_ptr_holder != nullptr) {
-      std::rethrow_exception(exception_ptr_holder);
+      records.splice(task.result(), from);
+      covered = std::max(covered, end_of(chunk_reader));
     }
   }
 }
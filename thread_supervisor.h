@@ -1,42 +1,112 @@
 #pragma once
 #include <vector>
 #include <exception>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 #include "record.h"
+#include "record_table.h"
+#include "segmented_table.h"
 #include "filereader.h"
+#include "stats.h"
 
 namespace dlt {
+  // the exception raised by the tasks of one supervisor
+  // we do not really care about how much exceptions or in what order they are: the first one is rethrown
+  class parse_failure final {
+  public:
+    // keeps the exception unless there is one already. thread-safe
+    void set(std::exception_ptr exception) noexcept;
+    // thread-safe
+    [[nodiscard]] bool is_set() const noexcept;
+    // rethrows the exception if there is one. it is reset, so the next execute is not affected
+    void rethrow();
+
+  private:
+    std::atomic<bool> failed_{ false };
+    std::mutex mutex_;
+    std::exception_ptr exception_;
+  };
+
   class task {
   public:
-    explicit task(std::unique_ptr<fs::reader> reader);
+    // the chunk is [begin, end) of the file. parsing stops early once cancelled or failure is set
+    // exceptions are not thrown but put to failure
+    task(std::unique_ptr<fs::reader> reader, const parse_options& options, std::size_t begin, std::size_t end,
+      const std::atomic<bool>& cancelled, parse_failure& failure);
     void execute();
     const fs::reader& get_reader() const;
 
     [[nodiscard]]
-    std::vector<Record>& result();
+    const std::shared_ptr<RecordTable>& result() const;
+
+    [[nodiscard]]
+    task_stats stats() const;
 
   private:
     std::unique_ptr<fs::reader> reader_;
-    std::vector<Record> records_;
+    parse_options options_;
+    std::shared_ptr<RecordTable> records_{ std::make_shared<RecordTable>() };
+    std::size_t begin_;
+    std::size_t end_;
+    const std::atomic<bool>* cancelled_;
+    parse_failure* failure_;
+    DLT_STATS(nanoseconds parse_time_{ 0 };)
   };
 
   class supervisor {
   public:
     inline static const auto cores_num = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
 
-    // we do not really care about how much exceptions or in what order they are
-    // if any exception is detected it will be rethrown
-    class : std::exception_ptr {
-      friend class supervisor;
-      friend class task;
-      using std::exception_ptr::operator=;
-    } inline static exception_ptr_holder{ };
-    
-    explicit supervisor(fs::reader&& reader);
-    void execute(std::vector<Record>& records);
+    // file is parsed in chunks of this size which are pulled by the worker threads one by one
+    // so a slow (e.g. heavily corrupted) region does not leave the rest of the workers idle
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 8 * 1024 * 1024;
+
+    // threads_num of 0 means one thread per core. never more than the shared thread pool provides
+    explicit supervisor(fs::reader&& reader, const parse_options& options = {}, unsigned threads_num = 0,
+      std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    // appends chunk tables to records as segments, nothing is copied
+    // returns the offset parsing ended at: the length of the file unless its tail is held (parse_options::hold_tail)
+    std::size_t execute(SegmentedTable& records);
+
+    // parses several files at once: the chunks of all of them share the same threads
+    // records[i] gets the result of supervisors[i], the returned offsets are the same as of execute
+    // an exception of one file stops the rest of its chunks only, the one of the first failed file is rethrown
+    static std::vector<std::size_t> execute(std::vector<supervisor>& supervisors, std::vector<SegmentedTable>& records);
+
+    // the same as execute, but every chunk is stitched to records as soon as it and all the chunks before it
+    // are parsed, so records grow by a file-ordered prefix. records are only changed under records_mutex,
+    // stitched(covered) is called after every change with the offset parsing has reached by then
+    // stitched must not throw. it is called by the parsing threads one at a time
+    std::size_t execute(SegmentedTable& records, std::mutex& records_mutex,
+      const std::function<void(std::size_t)>& stitched);
+
+    // stop parsing as soon as possible, execute returns whatever is stitched by then. thread-safe
+    void cancel() noexcept;
+
+    // of the last execute. counters and timers are gathered only when built with DLT_WITH_STATS
+    [[nodiscard]]
+    parse_stats stats() const;
 
   private:
-    uint8_t threads_num_{};
+    // stitches the parsed chunks [merged_, until) to the ones stitched before
+    void merge(SegmentedTable& records, std::size_t until);
+
+    unsigned threads_num_{};
+    std::size_t len_{};
+    parse_options options_;
     std::vector<task> tasks_;
+    // on the heap: tasks point to it and supervisors are moved
+    std::unique_ptr<std::atomic<bool>> cancelled_{ std::make_unique<std::atomic<bool>>(false) };
+    std::unique_ptr<parse_failure> failure_{ std::make_unique<parse_failure>() };
+    // state of merge: the chunks stitched so far and the end of the data they cover
+    std::size_t merged_{};
+    std::size_t covered_{};
+    std::size_t reparsed_bytes_{};
+    DLT_STATS(table_stats reparsed_stats_;)
+    DLT_STATS(nanoseconds merge_time_{ 0 };)
+    DLT_STATS(nanoseconds total_time_{ 0 };)
   };
 }
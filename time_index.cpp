@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include <limits>
+
+#include "time_index.h"
+
+namespace dlt {
+  namespace {
+    template <typename T>
+    void write(std::ostream& os, const std::vector<T>& column) {
+      os.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+    }
+
+    template <typename T>
+    bool read(std::istream& is, std::vector<T>& column, const std::size_t size) {
+      column.resize(size);
+      return static_cast<bool>(is.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(size * sizeof(T))));
+    }
+  }
+
+  TimeIndex::TimeIndex(const SegmentedTable& table, const std::size_t len, const std::size_t step)
+    : rows_(table.size()), len_(len) {
+    assert(step > 0);
+
+    microseconds latest = 0;
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      const auto [records, index] = table.locate(row);
+      if (row % step == 0) {
+        row_.push_back(row);
+        offset_.push_back(records.getOffset(index));
+        maxBefore_.push_back(latest);
+      }
+      if (!records.isCorrupted(index)) {
+        latest = std::max(latest, records.getTimeStamp(index));
+      }
+    }
+
+    // the earliest times are collected backwards
+    minFrom_.resize(row_.size());
+    auto earliest = std::numeric_limits<microseconds>::max();
+    auto row = table.size();
+    for (auto sample = row_.size(); sample-- > 0;) {
+      while (row > row_[sample]) {
+        const auto [records, index] = table.locate(--row);
+        if (!records.isCorrupted(index)) {
+          earliest = std::min(earliest, records.getTimeStamp(index));
+        }
+      }
+      minFrom_[sample] = earliest;
+    }
+  }
+
+  bool TimeIndex::empty() const noexcept {
+    return row_.empty();
+  }
+
+  TimeIndex::window TimeIndex::find(const microseconds from, const microseconds to) const {
+    // both are non-decreasing. start at the last sample with nothing of the range before it,
+    // end at the first one with nothing of the range from it on
+    const auto first = std::lower_bound(maxBefore_.cbegin(), maxBefore_.cend(), from) - maxBefore_.cbegin();
+    const auto begin = static_cast<std::size_t>(first == 0 ? 0 : first - 1);
+    const auto end = static_cast<std::size_t>(std::upper_bound(minFrom_.cbegin(), minFrom_.cend(), to) - minFrom_.cbegin());
+
+    if (begin >= end) {
+      // nothing in the range
+      const auto offset = end < row_.size() ? offset_[end] : len_;
+      const auto row = end < row_.size() ? row_[end] : rows_;
+      return { row, row, offset, offset };
+    }
+    return {
+      row_[begin],
+      end < row_.size() ? row_[end] : rows_,
+      offset_[begin],
+      end < row_.size() ? offset_[end] : len_
+    };
+  }
+
+  void TimeIndex::save(std::ostream& os) const {
+    const uint64_t samples = row_.size();
+    os.write(reinterpret_cast<const char*>(&samples), sizeof(samples));
+    os.write(reinterpret_cast<const char*>(&rows_), sizeof(rows_));
+    os.write(reinterpret_cast<const char*>(&len_), sizeof(len_));
+    write(os, row_);
+    write(os, offset_);
+    write(os, maxBefore_);
+    write(os, minFrom_);
+  }
+
+  bool TimeIndex::load(std::istream& is) {
+    uint64_t samples{};
+    if (!is.read(reinterpret_cast<char*>(&samples), sizeof(samples))
+      || !is.read(reinterpret_cast<char*>(&rows_), sizeof(rows_))
+      || !is.read(reinterpret_cast<char*>(&len_), sizeof(len_))
+      || samples > rows_
+      || !read(is, row_, samples) || !read(is, offset_, samples)
+      || !read(is, maxBefore_, samples) || !read(is, minFrom_, samples)) {
+      *this = {};
+      return false;
+    }
+    return true;
+  }
+}
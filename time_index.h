@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <iosfwd>
+
+#include "segmented_table.h"
+
+namespace dlt {
+  // sparse index of the storage header time: one sample every step rows of a parsed file
+  // times are almost monotonic within a file, so every sample keeps the latest time before it and the earliest
+  // one from it on. a window found by them holds every record of the time range even if a few are out of order
+  // corrupted records have no time and are ignored
+  class TimeIndex final {
+  public:
+    using microseconds = uint64_t;
+
+    static constexpr std::size_t DEFAULT_STEP = 1024;
+
+    // rows and byte range of the file which hold all the records with time in [from, to]
+    // the range starts at a record. it may hold records out of the time range, they are to be skipped by time
+    struct window {
+      std::size_t begin_row;
+      std::size_t end_row;
+      std::size_t begin_offset;
+      std::size_t end_offset;
+    };
+
+    TimeIndex() = default;
+    // len is the length of the parsed file (the end offset of the last window)
+    TimeIndex(const SegmentedTable& table, std::size_t len, std::size_t step = DEFAULT_STEP);
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] window find(microseconds from, microseconds to) const;
+
+    void save(std::ostream& os) const;
+    // returns false if the dump is broken (the index is left empty then)
+    [[nodiscard]] bool load(std::istream& is);
+
+  private:
+    /* samples */
+    std::vector<uint64_t> row_;
+    std::vector<uint64_t> offset_;
+    // the latest time of the rows before the sample
+    std::vector<microseconds> maxBefore_;
+    // the earliest time of the rows from the sample on
+    std::vector<microseconds> minFrom_;
+
+    uint64_t rows_{ 0 };
+    uint64_t len_{ 0 };
+  };
+}